@@ -0,0 +1,27 @@
+# Print the .text size of each program and the growth per value type
+# (relative to the first program)
+#   -DSIZE_EXECUTABLE=... -DCOUNTS=<number of types> -DPROGRAMS=<files>
+list(LENGTH COUNTS n)
+math(EXPR last "${n} - 1")
+foreach(i RANGE ${last})
+  list(GET COUNTS ${i} count)
+  list(GET PROGRAMS ${i} program)
+  execute_process(COMMAND ${SIZE_EXECUTABLE} ${program}
+    OUTPUT_VARIABLE output
+    RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "unable to get the size of ${program}")
+  endif()
+  # Berkeley format: header line, then "text data bss ..."
+  string(REGEX MATCH "\n[ \t]*([0-9]+)" line "${output}")
+  set(text ${CMAKE_MATCH_1})
+
+  if(i EQUAL 0)
+    set(base_count ${count})
+    set(base_text ${text})
+    message("${count} types: .text ${text} bytes")
+  else()
+    math(EXPR growth "(${text} - ${base_text}) / (${count} - ${base_count})")
+    message("${count} types: .text ${text} bytes (+${growth} bytes per type)")
+  endif()
+endforeach()
@@ -9,167 +9,3645 @@
 
 #include "program_options.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
 #include <iterator>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define PROGRAM_OPTIONS_HAS_MMAP
+#elif defined(_WIN32)
+#  include <io.h>
+#endif
+#include <cerrno>
+
+#if (defined(__GNUC__) || defined(__clang__))			\
+     && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define PROGRAM_OPTIONS_HAS_X86_SIMD
+#endif
 
 using internal_::OptionValueBase;
 using internal_::program_option_type;
 
 // =============================================================================
 
-void phl_op(const OptionValueBase* p)
+bool hn_sort (OptionValueBase* a, OptionValueBase* b)
+{
+     return a->help_name() < b->help_name();
+}
+
+bool index_sort (const std::pair<std::string, OptionValueBase*>& a,
+		 const std::pair<std::string, OptionValueBase*>& b)
+{
+     return a.first < b.first;
+}
+
+bool sln_sort (OptionValueBase* a, OptionValueBase* b)
+{
+     if (a->short_name().empty()
+	 || b->short_name().empty()) {
+	  return a->long_name() < b->long_name();
+     }
+     else {
+	  return a->short_name() < b->short_name();
+     }
+}
+
+// =============================================================================
+
+std::string quote_args(const program_option_type& argvv)
+{
+     std::string ret;
+     for (program_option_type::const_iterator it(argvv.begin())
+	       ; it != argvv.end() ; ++it) {
+	  ret += "'" + *it + "' ";
+     }
+     return ret;
+}
+
+//! Name of an option in error messages
+std::string display_name(const OptionValueBase* opt)
+{
+     if (!opt->long_name().empty()) {
+	  return "--" + opt->long_name();
+     }
+     if (!opt->short_name().empty()) {
+	  return "-" + opt->short_name();
+     }
+     return opt->help_name();
+}
+
+// =============================================================================
+
+namespace {
+     //! Fast non-cryptographic hash (word-at-a-time multiply/xorshift)
+     std::uint64_t hash_bytes(const char* data, std::size_t size, std::uint64_t hash)
+     {
+	  const std::uint64_t mul(0x9E3779B97F4A7C15ULL);
+	  std::uint64_t word(0);
+	  for (; size >= 8; data += 8, size -= 8) {
+	       std::memcpy(&word, data, 8);
+	       hash = (hash ^ word) * mul;
+	       hash ^= hash >> 32;
+	  }
+	  if (size > 0) {
+	       word = 0;
+	       std::memcpy(&word, data, size);
+	       hash = (hash ^ word ^ (static_cast<std::uint64_t>(size) << 56)) * mul;
+	       hash ^= hash >> 32;
+	  }
+	  return hash;
+     }
+}
+
+namespace internal_ {
+     //! State of the memoizing parse cache
+     struct ParseCache
+     {
+	  struct Entry
+	  {
+	       std::uint64_t hash;
+	       //! Arguments (without program name), each followed by a '\0'
+	       std::string key;
+	       int argc;
+	       //! Binary snapshot of the consumed values
+	       std::vector<char> snapshot;
+	  };
+	  typedef std::list<Entry> lru_type;
+	  typedef std::unordered_multimap<std::uint64_t, lru_type::iterator> index_type;
+
+	  ParseCache(std::size_t max_entries_a)
+	       : max_entries(max_entries_a)
+	       , hits(0)
+	       , misses(0)
+	       , all_dirty(false)
+	       {}
+
+	  std::size_t max_entries;
+	  std::size_t hits;
+	  std::size_t misses;
+
+	  //! Most recently used entries first
+	  lru_type entries;
+	  index_type index;
+
+	  //! Values of all the bound targets when the cache was enabled
+	  std::vector<char> baseline;
+	  //! Offset of each option value in baseline (one past the end last)
+	  std::vector<std::size_t> offsets;
+	  //! Whether the last call may have modified non-consumed targets
+	  bool all_dirty;
+	  //! Whether each option (by id) received its default in the last call
+	  std::vector<char> defaulted;
+     };
+
+     // ------------------------------------------------------------------------
+
+     //! Constraints between options compiled into bitmask rules
+     /** Each option is one bit (its id) of the packed set of options
+      *  present; each rule only keeps the words of that set it involves, so
+      *  that checking it takes a few word operations.
+      */
+     struct ConstraintSet
+     {
+	  enum KIND {
+	       EXCLUSIVE,	//!< At most one of the options
+	       AT_LEAST_ONE,	//!< At least one of the options
+	       REQUIRES,	//!< Subject present implies all the options
+	       CONFLICTS	//!< Subject present excludes all the options
+	  };
+
+	  //! Bits of one word of the set of options present
+	  typedef std::pair<std::size_t, std::uint64_t> mask_type;
+
+	  struct Rule
+	  {
+	       KIND kind;
+	       //! Subject of REQUIRES and CONFLICTS rules (NULL otherwise)
+	       OptionValueBase* subject;
+	       std::vector<OptionValueBase*> options;
+
+	       //! Compiled rule (see compile())
+	       std::size_t subject_bit;
+	       std::vector<mask_type> masks;
+	  };
+
+	  //! Compute the masks of the rules
+	  /** \param options All the options in id order
+	   */
+	  void compile(const std::vector<OptionValueBase*>& options)
+	       {
+		    std::unordered_map<const OptionValueBase*, std::size_t> ids;
+		    for (std::size_t id(0); id < options.size(); ++id) {
+			 ids[options[id]] = id;
+		    }
+		    for (std::size_t r(0); r < rules.size(); ++r) {
+			 Rule& rule(rules[r]);
+			 rule.subject_bit = (rule.subject == NULL
+					     ? 0 : ids[rule.subject]);
+			 rule.masks.clear();
+			 for (std::size_t o(0); o < rule.options.size(); ++o) {
+			      const std::size_t id(ids[rule.options[o]]);
+			      std::size_t m(0);
+			      while (m < rule.masks.size()
+				     && rule.masks[m].first != id / 64) {
+				   ++m;
+			      }
+			      if (m == rule.masks.size()) {
+				   rule.masks.push_back(mask_type(id / 64, 0));
+			      }
+			      rule.masks[m].second |= std::uint64_t(1) << (id % 64);
+			 }
+		    }
+		    seen.assign((options.size() + 63) / 64, 0);
+	       }
+
+	  bool is_seen(std::size_t bit) const
+	       {
+		    return (seen[bit / 64] >> (bit % 64)) & 1;
+	       }
+	  //! Number of options of the rule present (saturates at 2)
+	  unsigned int count_seen(const Rule& rule) const
+	       {
+		    unsigned int count(0);
+		    for (std::size_t m(0); count < 2 && m < rule.masks.size(); ++m) {
+			 const std::uint64_t word(seen[rule.masks[m].first]
+						  & rule.masks[m].second);
+			 count += (word == 0 ? 0 : (word & (word - 1)) == 0 ? 1 : 2);
+		    }
+		    return count;
+	       }
+	  //! Whether all the options of the rule are present
+	  bool all_seen(const Rule& rule) const
+	       {
+		    for (std::size_t m(0); m < rule.masks.size(); ++m) {
+			 const std::uint64_t mask(rule.masks[m].second);
+			 if ((seen[rule.masks[m].first] & mask) != mask) {
+			      return false;
+			 }
+		    }
+		    return true;
+	       }
+
+	  std::vector<Rule> rules;
+	  //! Packed set of the options present (bit i: option with id i)
+	  std::vector<std::uint64_t> seen;
+     };
+
+     // ------------------------------------------------------------------------
+
+     //! Base values saved by overlays (see set_overlay_base())
+     struct Overlay
+     {
+	  struct Saved
+	  {
+	       OptionValueBase* option;
+	       std::size_t id;
+	       //! Copy of the base value (see OptionValueBase::copy_value())
+	       void* copy;
+	       bool consumed;
+	  };
+
+	  ~Overlay()
+	       {
+		    discard();
+	       }
+
+	  //! Forget the base values (the current values are kept)
+	  void discard()
+	       {
+		    for (std::size_t i(0); i < saved.size(); ++i) {
+			 saved[i].option->destroy_copy(saved[i].copy);
+			 overridden[saved[i].id] = 0;
+		    }
+		    saved.clear();
+	       }
+
+	  std::unordered_map<const OptionValueBase*, std::size_t> ids;
+	  //! Constraint rules involving each option (by id)
+	  std::vector< std::vector<std::size_t> > rules;
+	  //! Whether each option (by id) is overridden
+	  std::vector<char> overridden;
+	  //! Base values of the overridden options, in order
+	  std::vector<Saved> saved;
+     };
+} // namespace internal_
+
+// =============================================================================
+
+namespace {
+     //! Run the tasks not yet taken by another thread
+     void run_validation(std::vector<internal_::ValidationTask>& tasks,
+			 std::atomic<std::size_t>& next)
+     {
+	  for (std::size_t i(next++); i < tasks.size(); i = next++) {
+	       tasks[i].error = (*tasks[i].check)(tasks[i].value);
+	  }
+     }
+}
+
+namespace internal_ {
+     //! Worker threads kept by a manager to run its validators
+     /** The threads wait between parses, so that each parse (or overlay)
+      *  only pays for waking them up.
+      */
+     struct ValidationPool
+     {
+	  explicit ValidationPool(std::size_t n_workers)
+	       : tasks(NULL)
+	       , next(0)
+	       , generation(0)
+	       , busy(0)
+	       , stop(false)
+	       {
+		    for (std::size_t t(0); t < n_workers; ++t) {
+			 threads.push_back(std::thread(&ValidationPool::work,
+						       this));
+		    }
+	       }
+	  ~ValidationPool()
+	       {
+		    {
+			 std::lock_guard<std::mutex> lock(mutex);
+			 stop = true;
+		    }
+		    wake.notify_all();
+		    for (std::size_t t(0); t < threads.size(); ++t) {
+			 threads[t].join();
+		    }
+	       }
+
+	  //! Run the tasks on the workers and on the calling thread
+	  void run(std::vector<ValidationTask>& batch)
+	       {
+		    {
+			 std::lock_guard<std::mutex> lock(mutex);
+			 tasks = &batch;
+			 next = 0;
+			 busy = threads.size();
+			 ++generation;
+		    }
+		    wake.notify_all();
+		    run_validation(batch, next);
+
+		    std::unique_lock<std::mutex> lock(mutex);
+		    while (busy > 0) {
+			 done.wait(lock);
+		    }
+		    tasks = NULL;
+	       }
+
+	  //! Main loop of a worker thread
+	  void work()
+	       {
+		    std::size_t seen(0);
+		    for (;;) {
+			 std::vector<ValidationTask>* batch(NULL);
+			 {
+			      std::unique_lock<std::mutex> lock(mutex);
+			      while (!stop && generation == seen) {
+				   wake.wait(lock);
+			      }
+			      if (stop) {
+				   return;
+			      }
+			      seen = generation;
+			      batch = tasks;
+			 }
+			 run_validation(*batch, next);
+
+			 std::lock_guard<std::mutex> lock(mutex);
+			 if (--busy == 0) {
+			      done.notify_one();
+			 }
+		    }
+	       }
+
+	  std::mutex mutex;
+	  std::condition_variable wake;
+	  std::condition_variable done;
+	  std::vector<std::thread> threads;
+	  std::vector<ValidationTask>* tasks;
+	  std::atomic<std::size_t> next;
+	  std::size_t generation;
+	  //! Number of workers still running tasks of the current batch
+	  std::size_t busy;
+	  bool stop;
+     };
+} // namespace internal_
+
+// =============================================================================
+
+namespace internal_ {
+     PROGRAM_OPTIONS_OPS_TEMPLATES(, int);
+     PROGRAM_OPTIONS_OPS_TEMPLATES(, unsigned int);
+     PROGRAM_OPTIONS_OPS_TEMPLATES(, double);
+     PROGRAM_OPTIONS_OPS_TEMPLATES(, std::string);
+     template struct flag_ops<bool>;
+
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(, int);
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(, unsigned int);
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(, double);
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(, std::string);
+} // namespace internal_
+
+// =============================================================================
+
+namespace {
+     using internal_::ValueOps;
+     using internal_::CountDependentOption;
+
+     std::string to_upper(std::string str)
+     {
+	  std::transform(str.begin(), str.end(), str.begin(), ::toupper);
+	  return str;
+     }
+
+     // -------------------------------------------------------------------------
+
+     //! Option bound to a value of the type described by a ValueOps table
+     class TypedOption : public OptionValueBase
+     {
+     public:
+	  TypedOption(const char* s_name,
+		      const char* l_name,
+		      const char* h_name,
+		      void* target,
+		      const ValueOps& ops,
+		      const char* desc,
+		      bool required)
+	       : OptionValueBase(s_name, l_name, h_name, desc, required)
+	       , target_(target)
+	       , ops_(&ops)
+	       , default_value_(NULL)
+	       {}
+	  TypedOption(const char* h_name,
+		      void* target,
+		      const ValueOps& ops,
+		      const char* desc,
+		      bool required)
+	       : OptionValueBase(h_name, desc, required)
+	       , target_(target)
+	       , ops_(&ops)
+	       , default_value_(NULL)
+	       {}
+	  ~TypedOption()
+	       {
+		    if (default_value_ != NULL) {
+			 ops_->destroy(default_value_);
+		    }
+	       }
+
+	  std::string schema() const
+	       {
+		    return OptionValueBase::schema() + '\0' + ops_->type().name();
+	       }
+
+	  bool save_value(std::vector<char>& out) const
+	       {
+		    return ops_->save(out, target_);
+	       }
+	  const char* restore_value(const char* begin, const char* end)
+	       {
+		    begin = ops_->restore(begin, end, target_);
+		    consumed_ = (begin != NULL);
+		    return begin;
+	       }
+
+	  bool uint_assign_to(unsigned int& val) const
+	       {
+		    return ops_->uint_assign(val, target_);
+	       }
+
+	  void* copy_value() const
+	       {
+		    return ops_->clone(target_);
+	       }
+	  void restore_copy(void* copy, bool consumed)
+	       {
+		    ops_->assign(target_, copy);
+		    ops_->destroy(copy);
+		    consumed_ = consumed;
+	       }
+	  void destroy_copy(void* copy) const
+	       {
+		    ops_->destroy(copy);
+	       }
+	  void clear_value()
+	       {
+		    if (ops_->clear != NULL) {
+			 ops_->clear(target_);
+		    }
+	       }
+
+	  std::string help_note() const
+	       {
+		    if (ops_->units == NULL) {
+			 return std::string();
+		    }
+		    return std::string("units: ") + ops_->units;
+	       }
+
+	  bool set_default(const std::function<void (void*)>& fill,
+			   const std::type_info& type,
+			   const std::string& description)
+	       {
+		    if (type != ops_->type()) {
+			 return false;
+		    }
+		    if (default_value_ != NULL) {
+			 ops_->destroy(default_value_);
+			 default_value_ = NULL;
+		    }
+		    default_ = fill;
+		    default_desc_ = description;
+		    return true;
+	       }
+
+	  bool apply_default()
+	       {
+		    return !consumed_ && assign_default_();
+	       }
+
+	  bool add_validator(const std::function<std::string (const void*)>& check,
+			     const std::type_info& type)
+	       {
+		    if (type != ops_->element_type()) {
+			 return false;
+		    }
+		    validators_.push_back(check);
+		    return true;
+	       }
+
+	  bool reserve_values(std::size_t n)
+	       {
+		    if (ops_->reserve == NULL) {
+			 return false;
+		    }
+		    ops_->reserve(target_, n);
+		    return true;
+	       }
+
+	  void validation_tasks(std::vector<internal_::ValidationTask>& tasks) const
+	       {
+		    if (!consumed_) {
+			 return;
+		    }
+		    std::vector<const void*> elements;
+		    ops_->elements(target_, elements);
+		    const bool scalar(ops_->type() == ops_->element_type());
+		    for (std::size_t v(0); v < validators_.size(); ++v) {
+			 for (std::size_t i(0); i < elements.size(); ++i) {
+			      const internal_::ValidationTask task = {
+				   &validators_[v],
+				   elements[i],
+				   this,
+				   scalar ? -1 : static_cast<std::ptrdiff_t>(i),
+				   std::string()
+			      };
+			      tasks.push_back(task);
+			 }
+		    }
+	       }
+
+     protected:
+	  //! Assign the default value (if any) to the target
+	  bool assign_default_()
+	       {
+		    if (!default_) {
+			 return false;
+		    }
+		    if (default_value_ == NULL) {
+			 // copy of the target so that T needs no default constructor
+			 void* value(ops_->clone(target_));
+			 default_(value);
+			 default_value_ = value;
+		    }
+		    ops_->assign(target_, default_value_);
+		    return true;
+	       }
+
+	  void* target_;
+	  const ValueOps* ops_;
+
+     private:
+	  TypedOption(const TypedOption&);
+	  TypedOption& operator=(const TypedOption&);
+
+	  std::function<void (void*)> default_;
+	  //! Default value computed on first use (NULL until then)
+	  void* default_value_;
+	  std::vector< std::function<std::string (const void*)> > validators_;
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for valued options
+     class NameValue : public TypedOption
+     {
+     public:
+	  NameValue(const char* s_name,
+		    const char* l_name,
+		    const char* h_name,
+		    void* target,
+		    const ValueOps& ops,
+		    const char* desc,
+		    bool required)
+	       : TypedOption(s_name, l_name, h_name, target, ops, desc, required)
+	       {}
+     
+	  int expected_values() { return consumed_ ? 0 : 1; }
+
+	  bool consume_value(const std::string& arg)
+	       {
+		    consumed_ = ops_->consume(arg, target_, 0);
+		    return consumed_;
+	       }
+
+	  bool complete() { return consumed_; }
+
+	  std::string usage_name() const
+	       {
+		    if (!short_name_.empty()) {
+			 return "[-" + short_name_ + " " + short_name_ + "]";
+		    }
+		    return "[--" + long_name_ + " "
+			 + static_cast<char>(toupper(long_name_[0])) + "]";
+	       }
+
+	  std::string help_entry() const
+	       {
+		    if (!short_name_.empty()) {
+			 return "-" + short_name_ + " [ --" + long_name_ + " ] "
+			      + to_upper(help_name_);
+		    }
+		    return "--" + long_name_ + " " + long_name_;
+	       }
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for valued options with more than one value
+     class NameVector : public TypedOption
+     {
+     public:
+	  NameVector(const char* s_name,
+		     const char* l_name,
+		     const char* h_name,
+		     void* target,
+		     const ValueOps& ops,
+		     unsigned int count,
+		     const char* desc,
+		     bool required)
+	       : TypedOption(s_name, l_name, h_name, target, ops, desc, required)
+	       , max_count_(count)
+	       , count_(0)
+	       {}
+     
+	  bool match()
+	       {
+		    count_ = 0;
+		    return true;
+	       }
+
+	  int expected_values() { return max_count_ - count_; }
+
+	  bool consume_value(const std::string& arg)
+	       {
+		    if (!ops_->consume(arg, target_, count_)) {
+			 return false;
+		    }
+		    ++count_;
+		    return true;
+	       }
+
+	  bool complete()
+	       {
+		    if (count_ != max_count_) {
+			 return false;
+		    }
+		    consumed_ = true;
+		    return true;
+	       }
+
+	  //! Each occurrence brings count values
+	  bool reserve_values(std::size_t n)
+	       {
+		    return TypedOption::reserve_values(n * max_count_);
+	       }
+
+	  std::string usage_name() const
+	       {
+		    std::string name("-" + short_name_);
+		    std::string value(short_name_);
+		    if (short_name_.empty()) {
+			 name = "--" + long_name_;
+			 value.assign(1, static_cast<char>(toupper(long_name_[0])));
+		    }
+
+		    std::string ret("[" + name);
+		    if (max_count_ < 5) {
+			 for (unsigned int c(0); c < max_count_; ++c) {
+			      ret += " " + value;
+			 }
+		    }
+		    else {
+			 ret += " " + value + " " + std::to_string(max_count_) + "x";
+		    }
+		    return ret + "]";
+	       }
+
+	  std::string help_entry() const
+	       {
+		    if (!short_name_.empty()) {
+			 std::string ret("-" + short_name_
+					 + " [ --" + long_name_ + " ] "
+					 + to_upper(help_name_));
+			 if (max_count_ > 1) {
+			      ret += " (" + std::to_string(max_count_) + "x)";
+			 }
+			 return ret;
+		    }
+		    return "--" + long_name_ + " " + long_name_;
+	       }
+
+	  std::string schema() const
+	       {
+		    return TypedOption::schema() + '\0' + std::to_string(max_count_);
+	       }
+
+     private:
+	  unsigned int max_count_;	  
+	  unsigned int count_;
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for flag options with particular value to assign
+     /** Switches (boolean options) are flags assigning true.
+      */
+     class FlagValue : public TypedOption
+     {
+     public:
+	  FlagValue(const char* s_name,
+		    const char* l_name,
+		    const char* h_name,
+		    void* target,
+		    const void* val_to_assign,
+		    const ValueOps& ops,
+		    const char* desc,
+		    bool required)
+	       : TypedOption(s_name, l_name, h_name, target, ops, desc, required)
+	       , value_to_assign_(ops.clone(val_to_assign))
+	       {}
+	  ~FlagValue() { ops_->destroy(value_to_assign_); }
+
+	  bool match()
+	       {
+		    if (consumed_) {
+			 return false;
+		    }
+		    ops_->assign(target_, value_to_assign_);
+		    consumed_ = true;
+		    return true;
+	       }
+
+	  int expected_values() { return 0; }
+	  bool consume_value(const std::string&) { return false; }
+
+	  std::string help_entry() const
+	       {
+		    if (!short_name_.empty()) {
+			 return "-" + short_name_ + " [ --" + long_name_ + " ] ";
+		    }
+		    return "--" + long_name_;
+	       }
+
+     private:
+	  void* value_to_assign_;
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for positional options with single value
+     class PositionalValue : public TypedOption
+     {
+     public:
+	  PositionalValue(const char* h_name,
+			  void* target,
+			  const ValueOps& ops,
+			  const char* desc,
+			  bool required)
+	       : TypedOption(h_name, target, ops, desc, required)
+	       {}
+     
+	  int expected_values() { return consumed_ ? 0 : 1; }
+
+	  bool consume_value(const std::string& arg)
+	       {
+		    consumed_ = ops_->consume(arg, target_, 0);
+		    return consumed_;
+	       }
+
+	  std::string help_entry() const
+	       {
+		    return help_name_;
+	       }
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for positional options with multiple values
+     class PositionalVector : public TypedOption
+     {
+     public:
+	  PositionalVector(const char* h_name,
+			   void* target,
+			   const ValueOps& ops,
+			   int max_count,
+			   const CountDependentOption& opt,
+			   const char* desc,
+			   bool required)
+	       : TypedOption(h_name, target, ops, desc, required)
+	       , count_(0)
+	       , exact_count_(opt.force_exact_count)
+	       , max_count_(max_count)
+	       , count_dep_opt_(opt)
+	       {}
+
+	  int expected_values()
+	       {
+		    if (max_count_ == 0 && count_dep_opt_.dependent != NULL) {
+			 unsigned int max_count(0);
+			 (count_dep_opt_.dependent->*count_dep_opt_.func)(max_count);
+			 max_count_ = max_count;
+		    }
+		    if (max_count_ < 0) {
+			 return -1;
+		    }
+		    return max_count_ - count_;
+	       }
+
+	  bool consume_value(const std::string& arg)
+	       {
+		    if (count_ == 0 && max_count_ > 0) {
+			 // the count may come from the command line: do not
+			 // trust it for more than a bounded reservation
+			 reserve_values(std::min(max_count_, 4096));
+		    }
+		    if (!ops_->consume(arg, target_, count_)) {
+			 return false;
+		    }
+		    ++count_;
+		    return true;
+	       }
+
+	  bool complete()
+	       {
+		    if (exact_count_ && expected_values() != 0) {
+			 return false;
+		    }
+		    consumed_ = true;
+		    return true;
+	       }
+
+	  bool skips_last() const { return max_count_ == -1; }
+
+	  //! Assign the default if no value was received (the option is
+	  //! consumed once complete, even without values)
+	  bool apply_default()
+	       {
+		    return count_ == 0 && assign_default_();
+	       }
+
+	  std::string help_entry() const
+	       {
+		    if (count_dep_opt_.dependent != NULL) {
+			 return help_name_
+			      + " (" + count_dep_opt_.dependent->help_name() + " x)";
+		    }
+		    else if (max_count_ > 1) {
+			 return help_name_ + " (" + std::to_string(max_count_) + "x)";
+		    }
+		    else if (max_count_ == -1) {
+			 return help_name_ + "1 "
+			      + help_name_ + "2 ... "
+			      + help_name_ + "N";
+		    }
+		    return help_name_;
+	       }
+
+	  std::string help_note() const
+	       {
+		    if (count_dep_opt_.dependent == NULL) {
+			 return std::string();
+		    }
+		    switch (count_dep_opt_.func_type) {
+		    case internal_::UINT_ASSIGN:
+			 return "-> count depends on "
+			      + count_dep_opt_.dependent->help_name();
+		    case internal_::BITCOUNT_ASSIGN:
+			 return "-> count depends on bitcount of "
+			      + count_dep_opt_.dependent->help_name();
+		    default:
+			 return "-> depends on "
+			      + count_dep_opt_.dependent->help_name()
+			      + "\nbut method is INVALID!";
+		    }
+	       }
+	  
+	  std::string schema() const
+	       {
+		    return TypedOption::schema()
+			 + '\0' + std::to_string(count_dep_opt_.name.empty() ? max_count_ : 0)
+			 + '\0' + std::to_string(exact_count_)
+			 + '\0' + count_dep_opt_.name
+			 + '\0' + std::to_string(count_dep_opt_.func_type);
+	       }
+
+	  void reset()
+	       {
+		    OptionValueBase::reset();
+		    count_ = 0;
+		    if (!count_dep_opt_.name.empty()) {
+			 max_count_ = 0;
+		    }
+	       }
+
+     private:
+	  unsigned int count_;
+	  bool exact_count_;
+	  int max_count_;
+	  CountDependentOption count_dep_opt_;
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for positional options handing each value to a callback
+     /** Values are not stored, which allows processing an unbounded number of
+      *  arguments (eg. read from an ArgumentSource) in bounded memory.
+      */
+     class PositionalCallback : public TypedOption
+     {
+     public:
+	  PositionalCallback(const char* h_name,
+			     const void* callback,
+			     const ValueOps& ops,
+			     const char* desc,
+			     bool required)
+	       : TypedOption(h_name, ops.clone(callback), ops, desc, required)
+	       {}
+	  ~PositionalCallback() { ops_->destroy(target_); }
+
+	  int expected_values() { return -1; }
+
+	  bool consume_value(const std::string& arg)
+	       {
+		    if (!ops_->consume(arg, target_, 0)) {
+			 return false;
+		    }
+		    consumed_ = true;
+		    return true;
+	       }
+
+	  std::string help_entry() const
+	       {
+		    return help_name_ + "...";
+	       }
+
+	  //! Values are not stored and thus have no default
+	  bool set_default(const std::function<void (void*)>&,
+			   const std::type_info&,
+			   const std::string&)
+	       {
+		    return false;
+	       }
+	  //! Values are not stored (the callback may check them instead)
+	  bool add_validator(const std::function<std::string (const void*)>&,
+			     const std::type_info&)
+	       {
+		    return false;
+	       }
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Finalizer of splitmix64 (every input bit affects every output bit)
+     std::uint64_t mix64(std::uint64_t x)
+     {
+	  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	  return x ^ (x >> 31);
+     }
+
+     //! Names of choices and their values, looked up through a perfect hash
+     /** Hash and displace: the names are spread over buckets by their hash,
+      *  then each bucket (largest first) gets the first displacement sending
+      *  all of its names to free slots of a power of two table. A lookup
+      *  costs one hash of the argument, one mix and one string comparison.
+      *  Names must be distinct (checked when the option is added).
+      */
+     class ChoiceSet
+     {
+     public:
+	  ChoiceSet(const ValueOps& ops,
+		    const std::vector<const char*>& names,
+		    const std::vector<const void*>& values)
+	       : ops_(&ops)
+	       , seed_(0)
+	       {
+		    for (std::size_t i(0) ; i < names.size() ; ++i) {
+			 names_.push_back(names[i]);
+			 values_.push_back(ops.clone(values[i]));
+		    }
+		    build_();
+	       }
+	  ~ChoiceSet()
+	       {
+		    for (std::size_t i(0) ; i < values_.size() ; ++i) {
+			 ops_->destroy(values_[i]);
+		    }
+	       }
+
+	  //! Value of the choice named arg (NULL if none)
+	  const void* find(const std::string& arg) const
+	       {
+		    if (names_.empty()) {
+			 return NULL;
+		    }
+		    const std::uint64_t hash(hash_(arg));
+		    const int idx(slots_[slot_(hash, displacements_[bucket_(hash)])]);
+		    return idx >= 0 && names_[idx] == arg ? values_[idx] : NULL;
+	       }
+
+	  //! Names of the choices, in the order of registration
+	  std::string list() const
+	       {
+		    std::string ret;
+		    for (std::size_t i(0) ; i < names_.size() ; ++i) {
+			 ret += (i == 0 ? "" : ", ") + names_[i];
+		    }
+		    return ret;
+	       }
+
+     private:
+	  ChoiceSet(const ChoiceSet&);
+	  ChoiceSet& operator=(const ChoiceSet&);
+
+	  std::uint64_t hash_(const std::string& name) const
+	       {
+		    return hash_bytes(name.data(), name.size(),
+				      seed_ ^ name.size());
+	       }
+	  std::size_t bucket_(std::uint64_t hash) const
+	       {
+		    return (hash >> 32) & (displacements_.size() - 1);
+	       }
+	  std::size_t slot_(std::uint64_t hash, std::uint32_t displacement) const
+	       {
+		    return mix64(hash + displacement * 0x9E3779B97F4A7C15ULL)
+			 & (slots_.size() - 1);
+	       }
+
+	  //! Looks for a seed and displacements without collisions
+	  /** The table grows after a few unsuccessful seeds (eg. if two
+	   *  names share a full hash value).
+	   */
+	  void build_()
+	       {
+		    std::size_t size(1);
+		    while (size < names_.size()) {
+			 size *= 2;
+		    }
+		    for (unsigned int attempt(1) ; ; ++attempt) {
+			 seed_ = mix64(attempt);
+			 if (place_(size)) {
+			      return;
+			 }
+			 if (attempt % 4 == 0) {
+			      size *= 2;
+			 }
+		    }
+	       }
+
+	  //! Tries to place all names in a table of size slots
+	  bool place_(std::size_t size)
+	       {
+		    const std::size_t n(names_.size());
+		    displacements_.assign(size, 0);
+		    slots_.assign(size, -1);
+
+		    std::vector<std::uint64_t> hashes(n);
+		    std::vector<std::vector<std::size_t> > buckets(size);
+		    for (std::size_t i(0) ; i < n ; ++i) {
+			 hashes[i] = hash_(names_[i]);
+			 buckets[bucket_(hashes[i])].push_back(i);
+		    }
+		    std::vector<std::size_t> order(size);
+		    for (std::size_t i(0) ; i < size ; ++i) {
+			 order[i] = i;
+		    }
+		    std::stable_sort(order.begin(), order.end(),
+				     larger_bucket(buckets));
+
+		    std::vector<std::size_t> taken;
+		    for (std::size_t b(0) ; b < size ; ++b) {
+			 const std::vector<std::size_t>& bucket(buckets[order[b]]);
+			 if (bucket.empty()) {
+			      break;
+			 }
+			 std::uint32_t d(0);
+			 for (; d < 64 * size ; ++d) {
+			      taken.clear();
+			      std::size_t i(0);
+			      for (; i < bucket.size() ; ++i) {
+				   const std::size_t s(slot_(hashes[bucket[i]], d));
+				   if (slots_[s] >= 0
+				       || std::find(taken.begin(), taken.end(), s)
+				       != taken.end()) {
+					break;
+				   }
+				   taken.push_back(s);
+			      }
+			      if (i == bucket.size()) {
+				   break;
+			      }
+			 }
+			 if (d == 64 * size) {
+			      return false;
+			 }
+			 displacements_[order[b]] = d;
+			 for (std::size_t i(0) ; i < bucket.size() ; ++i) {
+			      slots_[taken[i]] = static_cast<int>(bucket[i]);
+			 }
+		    }
+		    return true;
+	       }
+
+	  //! Orders bucket indices by decreasing number of names
+	  struct larger_bucket
+	  {
+	       larger_bucket(const std::vector<std::vector<std::size_t> >& b)
+		    : buckets(b)
+		    {}
+	       bool operator()(std::size_t lhs, std::size_t rhs) const
+		    {
+			 return buckets[lhs].size() > buckets[rhs].size();
+		    }
+	       const std::vector<std::vector<std::size_t> >& buckets;
+	  };
+
+	  const ValueOps* ops_;
+	  std::vector<std::string> names_;
+	  std::vector<void*> values_;
+	  std::uint64_t seed_;
+	  std::vector<std::uint32_t> displacements_;
+	  std::vector<int> slots_;
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for valued options selecting their value by name
+     class NameChoice : public NameValue
+     {
+     public:
+	  NameChoice(const char* s_name,
+		     const char* l_name,
+		     const char* h_name,
+		     void* target,
+		     const ValueOps& ops,
+		     const std::vector<const char*>& names,
+		     const std::vector<const void*>& values,
+		     const char* desc,
+		     bool required)
+	       : NameValue(s_name, l_name, h_name, target, ops, desc, required)
+	       , choices_(ops, names, values)
+	       {}
+
+	  bool consume_value(const std::string& arg)
+	       {
+		    const void* value(choices_.find(arg));
+		    if (value != NULL) {
+			 ops_->assign(target_, value);
+			 consumed_ = true;
+		    }
+		    return consumed_;
+	       }
+
+	  std::string help_note() const
+	       {
+		    return "choices: " + choices_.list();
+	       }
+	  std::string valid_values() const { return choices_.list(); }
+
+	  std::string schema() const
+	       {
+		    return NameValue::schema() + '\0' + choices_.list();
+	       }
+
+     private:
+	  ChoiceSet choices_;
+     };
+
+     // -------------------------------------------------------------------------
+
+     //! Sub-class for positional options selecting their value by name
+     class PositionalChoice : public PositionalValue
+     {
+     public:
+	  PositionalChoice(const char* h_name,
+			   void* target,
+			   const ValueOps& ops,
+			   const std::vector<const char*>& names,
+			   const std::vector<const void*>& values,
+			   const char* desc,
+			   bool required)
+	       : PositionalValue(h_name, target, ops, desc, required)
+	       , choices_(ops, names, values)
+	       {}
+
+	  bool consume_value(const std::string& arg)
+	       {
+		    const void* value(choices_.find(arg));
+		    if (value != NULL) {
+			 ops_->assign(target_, value);
+			 consumed_ = true;
+		    }
+		    return consumed_;
+	       }
+
+	  std::string help_note() const
+	       {
+		    return "choices: " + choices_.list();
+	       }
+	  std::string valid_values() const { return choices_.list(); }
+
+	  std::string schema() const
+	       {
+		    return PositionalValue::schema() + '\0' + choices_.list();
+	       }
+
+     private:
+	  ChoiceSet choices_;
+     };
+} // namespace
+
+// =============================================================================
+
+namespace internal_ {
+     OptionValueBase* make_named_value(const char* s_name,
+				       const char* l_name,
+				       const char* h_name,
+				       void* target,
+				       const ValueOps& ops,
+				       const char* desc,
+				       bool required)
+     {
+	  return new NameValue(s_name, l_name, h_name, target, ops,
+			       desc, required);
+     }
+
+     OptionValueBase* make_named_vector(const char* s_name,
+					const char* l_name,
+					const char* h_name,
+					void* target,
+					const ValueOps& ops,
+					unsigned int count,
+					const char* desc,
+					bool required)
+     {
+	  return new NameVector(s_name, l_name, h_name, target, ops, count,
+				desc, required);
+     }
+
+     OptionValueBase* make_flag(const char* s_name,
+				const char* l_name,
+				const char* h_name,
+				void* target,
+				const void* value,
+				const ValueOps& ops,
+				const char* desc,
+				bool required)
+     {
+	  return new FlagValue(s_name, l_name, h_name, target, value, ops,
+			       desc, required);
+     }
+
+     OptionValueBase* make_choice(const char* s_name,
+				  const char* l_name,
+				  const char* h_name,
+				  void* target,
+				  const ValueOps& ops,
+				  const std::vector<const char*>& names,
+				  const std::vector<const void*>& values,
+				  const char* desc,
+				  bool required)
+     {
+	  return new NameChoice(s_name, l_name, h_name, target, ops,
+				names, values, desc, required);
+     }
+
+     OptionValueBase* make_positional_value(const char* h_name,
+					    void* target,
+					    const ValueOps& ops,
+					    const char* desc,
+					    bool required)
+     {
+	  return new PositionalValue(h_name, target, ops, desc, required);
+     }
+
+     OptionValueBase* make_positional_choice(const char* h_name,
+					     void* target,
+					     const ValueOps& ops,
+					     const std::vector<const char*>& names,
+					     const std::vector<const void*>& values,
+					     const char* desc,
+					     bool required)
+     {
+	  return new PositionalChoice(h_name, target, ops, names, values,
+				      desc, required);
+     }
+
+     OptionValueBase* make_positional_vector(const char* h_name,
+					     void* target,
+					     const ValueOps& ops,
+					     int max_count,
+					     const CountDependentOption& dependent,
+					     const char* desc,
+					     bool required)
+     {
+	  return new PositionalVector(h_name, target, ops, max_count,
+				      dependent, desc, required);
+     }
+
+     OptionValueBase* make_positional_callback(const char* h_name,
+					       const void* callback,
+					       const ValueOps& ops,
+					       const char* desc,
+					       bool required)
+     {
+	  return new PositionalCallback(h_name, callback, ops, desc, required);
+     }
+
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 bool& value,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_value(short_name, long_name, long_name, value,
+			    desc, required);
+     }
+
+     OptionValueBase* make_value(const char* s_name,
+				 const char* l_name,
+				 const char* h_name,
+				 bool& value,
+				 const char* desc,
+				 bool required)
+     {
+	  const bool on(true);
+	  return make_flag(s_name, l_name, h_name, &value, &on,
+			   flag_ops<bool>::table, desc, required);
+     }
+
+     // -------------------------------------------------------------------------
+
+     // zero-initialized before any StaticOption is constructed
+     const StaticOption* StaticOption::first_(NULL);
+
+     StaticOption::StaticOption(const char* short_name,
+				const char* long_name,
+				bool& value,
+				const char* desc,
+				bool required)
+	  : short_name_(short_name)
+	  , long_name_(long_name)
+	  , desc_(desc)
+	  , target_(&value)
+	  , ops_(&flag_ops<bool>::table)
+	  , count_(0)
+	  , switch_(true)
+	  , required_(required)
+	  , next_(NULL)
+     {
+	  register_();
+     }
+
+     OptionValueBase* StaticOption::make_option() const
+     {
+	  if (switch_) {
+	       const bool on(true);
+	       return make_flag(short_name_, long_name_, long_name_, target_,
+				&on, *ops_, desc_, required_);
+	  }
+	  if (count_ > 0) {
+	       return make_named_vector(short_name_, long_name_, long_name_,
+					target_, *ops_, count_, desc_, required_);
+	  }
+	  return make_named_value(short_name_, long_name_, long_name_,
+				  target_, *ops_, desc_, required_);
+     }
+} // namespace internal_
+
+// =============================================================================
+
+namespace {
+     //! Size of the blocks holding interned strings
+     const std::size_t intern_block_size(64 * 1024);
+
+     //! FNV-1a hash
+     std::uint64_t intern_hash(const char* str, std::size_t size)
+     {
+	  std::uint64_t hash(14695981039346656037ULL);
+	  for (std::size_t i(0); i < size; ++i) {
+	       hash ^= static_cast<unsigned char>(str[i]);
+	       hash *= 1099511628211ULL;
+	  }
+	  return hash;
+     }
+
+     const internal_::InternEntry* intern_entry(const char* str)
+     {
+	  return reinterpret_cast<const internal_::InternEntry*>(str) - 1;
+     }
+}
+
+namespace internal_ {
+     bool operator<(InternedString a, InternedString b)
+     {
+	  if (a == b) {
+	       return false;
+	  }
+	  const std::size_t size(std::min(a.size(), b.size()));
+	  const int cmp(std::memcmp(a.c_str(), b.c_str(), size));
+	  return cmp < 0 || (cmp == 0 && a.size() < b.size());
+     }
+
+     InternPool::InternPool()
+	  : free_(NULL)
+	  , free_size_(0)
+	  , memory_(0)
+	  , table_(64, NULL)
+	  , count_(0)
+     {}
+
+     InternPool::~InternPool()
+     {
+	  for (std::size_t i(0); i < blocks_.size(); ++i) {
+	       delete[] blocks_[i];
+	  }
+     }
+
+     InternedString InternPool::intern(const char* str, std::size_t size)
+     {
+	  if (size == 0) {
+	       return InternedString();
+	  }
+
+	  const std::uint64_t hash(intern_hash(str, size));
+	  const std::size_t mask(table_.size() - 1);
+	  std::size_t slot(static_cast<std::size_t>(hash) & mask);
+	  for (; table_[slot] != NULL; slot = (slot + 1) & mask) {
+	       const InternEntry* entry(intern_entry(table_[slot]));
+	       if (entry->hash == hash && entry->size == size
+		   && std::memcmp(table_[slot], str, size) == 0) {
+		    return InternedString(table_[slot]);
+	       }
+	  }
+
+	  // entries are kept aligned for their header
+	  const std::size_t align(sizeof(InternEntry));
+	  const std::size_t n((sizeof(InternEntry) + size + 1 + align - 1)
+			      / align * align);
+	  char* p(allocate_(n));
+	  InternEntry* entry(reinterpret_cast<InternEntry*>(p));
+	  entry->size = size;
+	  entry->hash = hash;
+	  char* stored(p + sizeof(InternEntry));
+	  std::memcpy(stored, str, size);
+	  stored[size] = '\0';
+
+	  table_[slot] = stored;
+	  // load factor kept below 1/2
+	  if (++count_ * 2 > table_.size()) {
+	       grow_table_();
+	  }
+	  return InternedString(stored);
+     }
+
+     char* InternPool::allocate_(std::size_t n)
+     {
+	  if (n > free_size_) {
+	       // long strings get a block of their own
+	       const std::size_t size(std::max(n, intern_block_size));
+	       blocks_.push_back(new char[size]);
+	       memory_ += size;
+	       if (size > intern_block_size) {
+		    return blocks_.back();
+	       }
+	       free_ = blocks_.back();
+	       free_size_ = size;
+	  }
+	  char* p(free_);
+	  free_ += n;
+	  free_size_ -= n;
+	  return p;
+     }
+
+     void InternPool::grow_table_()
+     {
+	  std::vector<const char*> table(table_.size() * 2, NULL);
+	  const std::size_t mask(table.size() - 1);
+	  for (std::size_t i(0); i < table_.size(); ++i) {
+	       if (table_[i] == NULL) {
+		    continue;
+	       }
+	       std::size_t slot(static_cast<std::size_t>(intern_entry(table_[i])->hash)
+				& mask);
+	       while (table[slot] != NULL) {
+		    slot = (slot + 1) & mask;
+	       }
+	       table[slot] = table_[i];
+	  }
+	  table_.swap(table);
+     }
+} // namespace internal_
+
+// =============================================================================
+
+namespace {
+     //! Deleter of mapped files
+     struct unmapper
+     {
+	  void operator()(const void* data) const
+	       {
+#ifdef PROGRAM_OPTIONS_HAS_MMAP
+		    ::munmap(const_cast<void*>(data), size);
+#endif /* PROGRAM_OPTIONS_HAS_MMAP */
+	       }
+	  std::size_t size;
+     };
+
+     //! Deleter of static data
+     struct no_delete
+     {
+	  void operator()(const void*) const {}
+     };
+}
+
+std::shared_ptr<const void> internal_::map_file(const std::string& path,
+						const void*& data,
+						std::size_t& size)
+{
+#ifdef PROGRAM_OPTIONS_HAS_MMAP
+     const int fd(::open(path.c_str(), O_RDONLY));
+     struct stat st;
+     if (fd < 0 || ::fstat(fd, &st) != 0) {
+	  if (fd >= 0) {
+	       ::close(fd);
+	  }
+	  return std::shared_ptr<const void>();
+     }
+     size = st.st_size;
+     if (size == 0) {
+	  ::close(fd);
+	  static const char empty('\0');
+	  data = &empty;
+	  return std::shared_ptr<const void>(data, no_delete());
+     }
+
+     void* mapping(::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0));
+     ::close(fd);
+     if (mapping == MAP_FAILED) {
+	  return std::shared_ptr<const void>();
+     }
+     data = mapping;
+     const unmapper unmap = {size};
+     return std::shared_ptr<const void>(mapping, unmap);
+#else
+     std::FILE* in(std::fopen(path.c_str(), "rb"));
+     if (in == NULL) {
+	  return std::shared_ptr<const void>();
+     }
+     std::shared_ptr< std::vector<char> > buffer(
+	  std::make_shared< std::vector<char> >());
+     char chunk[4096];
+     for (std::size_t n; (n = std::fread(chunk, 1, sizeof(chunk), in)) > 0; ) {
+	  buffer->insert(buffer->end(), chunk, chunk + n);
+     }
+     std::fclose(in);
+     buffer->push_back('\0');
+     data = &(*buffer)[0];
+     size = buffer->size() - 1;
+     return buffer;
+#endif /* PROGRAM_OPTIONS_HAS_MMAP */
+}
+
+bool internal_::for_each_file_value(const std::string& path,
+				    const std::function<bool (const std::string&)>& f)
+{
+     const void* data(NULL);
+     std::size_t size(0);
+     const std::shared_ptr<const void> file(map_file(path, data, size));
+     if (!file) {
+	  return false;
+     }
+
+     const char* it(static_cast<const char*>(data));
+     const char* const end(it + size);
+     std::string value;
+     while (it != end) {
+	  const char* value_end(it);
+	  while (value_end != end && *value_end != ',' && *value_end != ' '
+		 && *value_end != '\t' && *value_end != '\n'
+		 && *value_end != '\r') {
+	       ++value_end;
+	  }
+	  if (value_end != it) {
+	       value.assign(it, value_end);
+	       if (!f(value)) {
+		    return false;
+	       }
+	  }
+	  it = (value_end == end ? end : value_end + 1);
+     }
+     return true;
+}
+
+// =============================================================================
+
+ProgramOptionManager::ProgramOptionManager(const char* prog_name,
+					   const char* desc)
+     : prog_name_(prog_name)
+     , desc_(desc)
+     , help_(false)
+     , finalized_(false)
+     , static_options_(false)
+     , cache_(NULL)
+     , constraints_(NULL)
+     , overlay_(NULL)
+     , limited_(false)
+     , validation_threads_(0)
+     , validation_pool_(NULL)
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+     , err_(&std::cerr)
+     , out_(&std::cout)
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+{}
+
+ProgramOptionManager::~ProgramOptionManager()
+{
+     // (base values are destroyed by their options)
+     delete overlay_;
+     std::for_each(positionals_.begin(), positionals_.end(), deleter());
+     std::for_each(opts_.begin(), opts_.end(), deleter());
+     delete cache_;
+     delete constraints_;
+     delete validation_pool_;
+}
+
+// =============================================================================
+
+void ProgramOptionManager::finalize_()
+{
+     if (finalized_) {
+	  return;
+     }
+     add_static_options_();
+     add_option("h", "help", help_, "Show this help and exit");
+
+     // std::sort(positionals_.begin(), positionals_.end(), hn_sort);
+     std::sort(opts_.begin(), opts_.end(), sln_sort);
+
+     for (const_iterator it(opts_.begin()) ; it < opts_.end() ; ++it) {
+	  if (!(*it)->short_name().empty()) {
+	       index_.push_back(index_entry("-" + (*it)->short_name(), *it));
+	  }
+	  if (!(*it)->long_name().empty()) {
+	       index_.push_back(index_entry("--" + (*it)->long_name(), *it));
+	  }
+	  if ((*it)->reserve_values(0)) {
+	       presized_.push_back(*it);
+	  }
+     }
+     // sorted for lookups by presize_()
+     std::sort(presized_.begin(), presized_.end(),
+	       std::less<OptionValueBase*>());
+     // stable: the first option registered with a given name wins
+     std::stable_sort(index_.begin(), index_.end(), index_sort);
+
+     if (constraints_ != NULL) {
+	  std::vector<OptionValueBase*> options(positionals_);
+	  options.insert(options.end(), opts_.begin(), opts_.end());
+	  constraints_->compile(options);
+     }
+     finalized_ = true;
+}
+
+void ProgramOptionManager::presize_(int argc, char** argv)
+{
+     if (presized_.empty()
+	 || (limited_ && argc > 0
+	     && static_cast<std::size_t>(argc - 1) > limits_.max_arguments)) {
+	  // (the parsing is bound to fail)
+	  return;
+     }
+
+     std::vector<std::size_t> counts(presized_.size(), 0);
+     std::string name;
+     for (int i(1); i < argc; ++i) {
+	  const char* arg(argv[i]);
+	  if (arg[0] != '-') {
+	       continue;
+	  }
+	  if (arg[1] == '-' && arg[2] == '\0') {
+	       break;
+	  }
+	  // same splitting of short options as ParseEventStream
+	  name.assign(arg, arg[1] == '-' ? std::strlen(arg) : 2);
+	  OptionValueBase* opt(find_option_(name));
+	  std::vector<OptionValueBase*>::const_iterator it(
+	       std::lower_bound(presized_.begin(), presized_.end(), opt,
+				std::less<OptionValueBase*>()));
+	  if (opt != NULL && it != presized_.end() && *it == opt) {
+	       ++counts[it - presized_.begin()];
+	  }
+     }
+     for (std::size_t p(0); p < presized_.size(); ++p) {
+	  if (counts[p] > 0) {
+	       presized_[p]->reserve_values(counts[p]);
+	  }
+     }
+}
+
+OptionValueBase* ProgramOptionManager::find_option_(const std::string& arg) const
+{
+     std::vector<index_entry>::const_iterator it(
+	  std::lower_bound(index_.begin(), index_.end(),
+			   index_entry(arg, NULL), index_sort));
+     if (it != index_.end() && it->first == arg) {
+	  return it->second;
+     }
+     return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+void ProgramOptionManager::set_error_stream(std::ostream& err)
+{
+     err_ = &err;
+}
+
+void ProgramOptionManager::set_output_stream(std::ostream& out)
+{
+     out_ = &out;
+}
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+void ProgramOptionManager::report_(const std::string& message) const
+{
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+     *err_ << "ERROR: " << message << std::endl;
+#else
+     (void) message;
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+}
+
+int ProgramOptionManager::fail_(ParseEvent::ERROR_CODE code,
+				std::ptrdiff_t token,
+				const OptionValueBase* opt)
+{
+     error_.code = code;
+     error_.token = token;
+     error_.option = option_id_(opt);
+     return -1;
+}
+
+void ProgramOptionManager::reset()
+{
+     help_ = false;
+     for (std::size_t idx(0); idx < positionals_.size() + opts_.size(); ++idx) {
+	  option_at_(idx)->reset();
+     }
+}
+
+// -----------------------------------------------------------------------------
+
+void ProgramOptionManager::set_default_(const char* name,
+					const std::function<void (void*)>& fill,
+					const std::type_info& type,
+					const std::string& description)
+{
+     OptionValueBase* opt(option_named_(name));
+     if (opt == NULL) {
+	  report_(std::string("no option named ") + name + "!");
+     }
+     else if (!opt->set_default(fill, type, description)) {
+	  report_(std::string("default value of ") + name
+		  + " does not match the type of the option!");
+     }
+}
+
+void ProgramOptionManager::apply_defaults_()
+{
+     for (std::size_t idx(0); idx < positionals_.size() + opts_.size(); ++idx) {
+	  if (option_at_(idx)->apply_default() && cache_ != NULL) {
+	       // restored to the baseline before the next cached parse
+	       cache_->defaulted[idx] = 1;
+	  }
+     }
+}
+
+// -----------------------------------------------------------------------------
+
+ProgramOptionManager&
+ProgramOptionManager::add_exclusive_group(std::initializer_list<const char*> names)
+{
+     add_constraint_(internal_::ConstraintSet::EXCLUSIVE, NULL, names);
+     return *this;
+}
+
+ProgramOptionManager&
+ProgramOptionManager::add_required_group(std::initializer_list<const char*> names)
+{
+     add_constraint_(internal_::ConstraintSet::AT_LEAST_ONE, NULL, names);
+     return *this;
+}
+
+ProgramOptionManager&
+ProgramOptionManager::add_requirement(const char* name,
+				      std::initializer_list<const char*> names)
+{
+     add_constraint_(internal_::ConstraintSet::REQUIRES, name, names);
+     return *this;
+}
+
+ProgramOptionManager&
+ProgramOptionManager::add_conflict(const char* name,
+				   std::initializer_list<const char*> names)
+{
+     add_constraint_(internal_::ConstraintSet::CONFLICTS, name, names);
+     return *this;
+}
+
+bool ProgramOptionManager::check_choices_(const char* name,
+					 const std::vector<const char*>& names) const
+{
+     if (names.empty()) {
+	  report_(std::string("no choices given for ") + name + "!");
+	  return false;
+     }
+     std::vector<std::string> sorted(names.begin(), names.end());
+     std::sort(sorted.begin(), sorted.end());
+     std::vector<std::string>::const_iterator it(
+	  std::adjacent_find(sorted.begin(), sorted.end()));
+     if (it != sorted.end()) {
+	  report_("choice " + *it + " given more than once for " + name + "!");
+	  return false;
+     }
+     return true;
+}
+
+void ProgramOptionManager::add_constraint_(int kind,
+					   const char* name,
+					   std::initializer_list<const char*> names)
+{
+     internal_::ConstraintSet::Rule rule;
+     rule.kind = static_cast<internal_::ConstraintSet::KIND>(kind);
+     rule.subject = NULL;
+     rule.subject_bit = 0;
+     if (name != NULL) {
+	  rule.subject = option_named_(name);
+	  if (rule.subject == NULL) {
+	       report_(std::string("no option named ") + name + "!");
+	       return;
+	  }
+     }
+     for (std::initializer_list<const char*>::iterator it(names.begin())
+	       ; it != names.end() ; ++it) {
+	  OptionValueBase* opt(option_named_(*it));
+	  if (opt == NULL) {
+	       report_(std::string("no option named ") + *it + "!");
+	       return;
+	  }
+	  rule.options.push_back(opt);
+     }
+
+     if (constraints_ == NULL) {
+	  constraints_ = new internal_::ConstraintSet;
+     }
+     constraints_->rules.push_back(rule);
+     if (finalized_) {
+	  std::vector<OptionValueBase*> options(positionals_);
+	  options.insert(options.end(), opts_.begin(), opts_.end());
+	  constraints_->compile(options);
+     }
+}
+
+int ProgramOptionManager::check_constraints_()
+{
+     if (constraints_ == NULL || constraints_->rules.empty()) {
+	  return 1;
+     }
+
+     internal_::ConstraintSet& set(*constraints_);
+     std::fill(set.seen.begin(), set.seen.end(), 0);
+     for (std::size_t idx(0); idx < positionals_.size() + opts_.size(); ++idx) {
+	  if (option_at_(idx)->consumed()) {
+	       set.seen[idx / 64] |= std::uint64_t(1) << (idx % 64);
+	  }
+     }
+
+     int retval(1);
+     for (std::size_t r(0); r < set.rules.size(); ++r) {
+	  retval = check_rule_(r, retval);
+     }
+     return retval;
+}
+
+int ProgramOptionManager::check_rule_(std::size_t r, int retval)
+{
+     const internal_::ConstraintSet& set(*constraints_);
+     const internal_::ConstraintSet::Rule& rule(set.rules[r]);
+     const OptionValueBase* culprit(rule.subject);
+     std::string message;
+
+     switch (rule.kind) {
+     case internal_::ConstraintSet::EXCLUSIVE:
+	  if (set.count_seen(rule) > 1) {
+	       std::vector<std::string> present;
+	       for (std::size_t o(0); o < rule.options.size(); ++o) {
+		    if (rule.options[o]->consumed()) {
+			 present.push_back(display_name(rule.options[o]));
+			 culprit = culprit == NULL ? rule.options[o] : culprit;
+		    }
+	       }
+	       message = present[0] + " and " + present[1]
+		    + " cannot be used together";
+	  }
+	  break;
+     case internal_::ConstraintSet::AT_LEAST_ONE:
+	  if (set.count_seen(rule) == 0) {
+	       message = "one of";
+	       for (std::size_t o(0); o < rule.options.size(); ++o) {
+		    message += (o == 0 ? " " : ", ")
+			 + display_name(rule.options[o]);
+	       }
+	       message += " is required";
+	       culprit = rule.options.empty() ? NULL : rule.options[0];
+	  }
+	  break;
+     case internal_::ConstraintSet::REQUIRES:
+	  if (set.is_seen(rule.subject_bit) && !set.all_seen(rule)) {
+	       std::size_t o(0);
+	       while (rule.options[o]->consumed()) {
+		    ++o;
+	       }
+	       message = display_name(rule.subject) + " requires "
+		    + display_name(rule.options[o]);
+	  }
+	  break;
+     case internal_::ConstraintSet::CONFLICTS:
+	  if (set.is_seen(rule.subject_bit) && set.count_seen(rule) > 0) {
+	       std::size_t o(0);
+	       while (!rule.options[o]->consumed()) {
+		    ++o;
+	       }
+	       message = display_name(rule.subject)
+		    + " cannot be used with "
+		    + display_name(rule.options[o]);
+	  }
+	  break;
+     }
+
+     if (!message.empty()) {
+	  report_(message);
+	  if (retval > 0) {
+	       retval = fail_(ParseEvent::CONSTRAINT_VIOLATED, -1, culprit);
+	  }
+     }
+     return retval;
+}
+
+// -----------------------------------------------------------------------------
+
+void ProgramOptionManager::add_validator_(const char* name,
+					  const std::function<std::string (const void*)>& check,
+					  const std::type_info& type)
+{
+     OptionValueBase* opt(option_named_(name));
+     if (opt == NULL) {
+	  report_(std::string("no option named ") + name + "!");
+     }
+     else if (!opt->add_validator(check, type)) {
+	  report_(std::string("validator of ") + name
+		  + " does not match the type of the option!");
+     }
+}
+
+namespace {
+     //! Check access to a path (mode: 0 for existence, 4 for reading)
+     std::string check_access(const std::string& path, int mode)
+     {
+#ifdef _WIN32
+	  const int ret(::_access(path.c_str(), mode));
+#else
+	  const int ret(::access(path.c_str(), mode == 0 ? F_OK : R_OK));
+#endif /* _WIN32 */
+	  if (ret == 0) {
+	       return std::string();
+	  }
+	  if (errno == ENOENT || errno == ENOTDIR) {
+	       return "'" + path + "' does not exist";
+	  }
+	  return "'" + path + "' cannot be accessed";
+     }
+
+     std::string check_exists(const std::string& path)
+     {
+	  return check_access(path, 0);
+     }
+     std::string check_readable(const std::string& path)
+     {
+	  return check_access(path, 4);
+     }
+}
+
+// -----------------------------------------------------------------------------
+
+namespace {
+     const std::size_t utf8_valid(static_cast<std::size_t>(-1));
+
+     //! Length of the ASCII prefix of [data, data + size)
+     typedef std::size_t (*ascii_prefix_func)(const unsigned char* data,
+					      std::size_t size);
+
+     std::size_t ascii_prefix_scalar(const unsigned char* data, std::size_t size)
+     {
+	  std::size_t i(0);
+	  for (; i + 8 <= size; i += 8) {
+	       std::uint64_t word;
+	       std::memcpy(&word, data + i, 8);
+	       if ((word & 0x8080808080808080ULL) != 0) {
+		    break;
+	       }
+	  }
+	  while (i < size && data[i] < 0x80) {
+	       ++i;
+	  }
+	  return i;
+     }
+
+#ifdef PROGRAM_OPTIONS_HAS_X86_SIMD
+     __attribute__((target("sse2")))
+     std::size_t ascii_prefix_sse2(const unsigned char* data, std::size_t size)
+     {
+	  std::size_t i(0);
+	  for (; i + 16 <= size; i += 16) {
+	       const __m128i block(_mm_loadu_si128(
+				       reinterpret_cast<const __m128i*>(data + i)));
+	       const int mask(_mm_movemask_epi8(block));
+	       if (mask != 0) {
+		    return i + __builtin_ctz(mask);
+	       }
+	  }
+	  return i + ascii_prefix_scalar(data + i, size - i);
+     }
+
+     __attribute__((target("avx2")))
+     std::size_t ascii_prefix_avx2(const unsigned char* data, std::size_t size)
+     {
+	  std::size_t i(0);
+	  for (; i + 32 <= size; i += 32) {
+	       const __m256i block(_mm256_loadu_si256(
+				       reinterpret_cast<const __m256i*>(data + i)));
+	       const unsigned int mask(_mm256_movemask_epi8(block));
+	       if (mask != 0) {
+		    return i + __builtin_ctz(mask);
+	       }
+	  }
+	  return i + ascii_prefix_sse2(data + i, size - i);
+     }
+#endif /* PROGRAM_OPTIONS_HAS_X86_SIMD */
+
+     //! Widest implementation supported by the processor
+     ascii_prefix_func select_ascii_prefix()
+     {
+#ifdef PROGRAM_OPTIONS_HAS_X86_SIMD
+	  __builtin_cpu_init();
+	  if (__builtin_cpu_supports("avx2")) {
+	       return ascii_prefix_avx2;
+	  }
+	  if (__builtin_cpu_supports("sse2")) {
+	       return ascii_prefix_sse2;
+	  }
+#endif /* PROGRAM_OPTIONS_HAS_X86_SIMD */
+	  return ascii_prefix_scalar;
+     }
+
+     //! Length of the UTF-8 sequence starting at data (0 if invalid)
+     /** Follows table 3-7 of the Unicode standard: overlong encodings,
+      *  surrogates and code points above U+10FFFF are invalid.
+      */
+     std::size_t utf8_sequence(const unsigned char* data, std::size_t size)
+     {
+	  const unsigned char c(data[0]);
+	  std::size_t n(0);
+	  unsigned char low(0x80);
+	  unsigned char high(0xBF);
+	  if (c >= 0xC2 && c <= 0xDF) {
+	       n = 2;
+	  }
+	  else if (c >= 0xE0 && c <= 0xEF) {
+	       n = 3;
+	       low = (c == 0xE0 ? 0xA0 : 0x80);
+	       high = (c == 0xED ? 0x9F : 0xBF);
+	  }
+	  else if (c >= 0xF0 && c <= 0xF4) {
+	       n = 4;
+	       low = (c == 0xF0 ? 0x90 : 0x80);
+	       high = (c == 0xF4 ? 0x8F : 0xBF);
+	  }
+	  if (n == 0 || n > size || data[1] < low || data[1] > high) {
+	       return 0;
+	  }
+	  for (std::size_t i(2); i < n; ++i) {
+	       if ((data[i] & 0xC0) != 0x80) {
+		    return 0;
+	       }
+	  }
+	  return n;
+     }
+
+     //! Offset of the first invalid UTF-8 sequence (utf8_valid if none)
+     /** ASCII runs are skipped a vector at a time, other characters are
+      *  decoded one sequence at a time.
+      */
+     std::size_t utf8_error(const char* str, std::size_t size)
+     {
+	  static const ascii_prefix_func ascii_prefix(select_ascii_prefix());
+
+	  const unsigned char* data(reinterpret_cast<const unsigned char*>(str));
+	  std::size_t i(0);
+	  while (i < size) {
+	       i += ascii_prefix(data + i, size - i);
+	       while (i < size && data[i] >= 0x80) {
+		    const std::size_t n(utf8_sequence(data + i, size - i));
+		    if (n == 0) {
+			 return i;
+		    }
+		    i += n;
+	       }
+	  }
+	  return utf8_valid;
+     }
+
+     std::string check_utf8(const std::string& str)
+     {
+	  const std::size_t error(utf8_error(str.data(), str.size()));
+	  if (error == utf8_valid) {
+	       return std::string();
+	  }
+	  return "invalid UTF-8 at byte " + std::to_string(error);
+     }
+}
+
+internal_::Validator<std::string> internal_::valid_utf8()
+{
+     return Validator<std::string>(check_utf8);
+}
+
+internal_::Validator<std::string> internal_::existing_path()
+{
+     return Validator<std::string>(check_exists);
+}
+
+internal_::Validator<std::string> internal_::readable_path()
+{
+     return Validator<std::string>(check_readable);
+}
+
+// =============================================================================
+
+namespace {
+     struct unit_scale
+     {
+	  const char* name;
+	  std::uint64_t scale;
+     };
+
+     const std::uint64_t max_u64(std::numeric_limits<std::uint64_t>::max());
+
+     const unit_scale size_units[] = {
+	  {"B", 1ULL},
+	  {"kB", 1000ULL}, {"KB", 1000ULL}, {"KiB", 1ULL << 10},
+	  {"MB", 1000000ULL}, {"MiB", 1ULL << 20},
+	  {"GB", 1000000000ULL}, {"GiB", 1ULL << 30},
+	  {"TB", 1000000000000ULL}, {"TiB", 1ULL << 40},
+	  {NULL, 0}
+     };
+
+     const unit_scale duration_units[] = {
+	  {"ns", 1ULL}, {"us", 1000ULL}, {"\xC2\xB5s", 1000ULL},
+	  {"ms", 1000000ULL}, {"s", 1000000000ULL},
+	  {"m", 60000000000ULL}, {"min", 60000000000ULL},
+	  {"h", 3600000000000ULL},
+	  {NULL, 0}
+     };
+
+     std::uint64_t gcd(std::uint64_t a, std::uint64_t b)
+     {
+	  while (b != 0) {
+	       const std::uint64_t r(a % b);
+	       a = b;
+	       b = r;
+	  }
+	  return a;
+     }
+
+     //! Parse "<digits>[.<digits>][unit]" into an exact 64-bit quantity
+     /** \param unit Scale of values without a unit
+      *  \return False if the syntax or the unit are invalid, if the
+      *          quantity is fractional or if it overflows
+      */
+     bool parse_quantity(const std::string& arg,
+			 const unit_scale* units,
+			 std::uint64_t unit,
+			 std::uint64_t& value)
+     {
+	  const char* str(arg.c_str());
+	  const char* end(str + arg.size());
+
+	  std::uint64_t whole(0);
+	  const char* digits(str);
+	  for (; str != end && static_cast<unsigned>(*str - '0') < 10; ++str) {
+	       const unsigned d(static_cast<unsigned>(*str - '0'));
+	       if (whole > (max_u64 - d) / 10) {
+		    return false;
+	       }
+	       whole = whole * 10 + d;
+	  }
+	  bool any_digit(str != digits);
+
+	  // Fraction as frac / den with den = 10^k (at most 18 digits)
+	  std::uint64_t frac(0), den(1);
+	  if (str != end && *str == '.') {
+	       for (++str; str != end && static_cast<unsigned>(*str - '0') < 10; ++str) {
+		    if (den == 1000000000000000000ULL) {
+			 return false;
+		    }
+		    frac = frac * 10 + static_cast<unsigned>(*str - '0');
+		    den *= 10;
+		    any_digit = true;
+	       }
+	  }
+	  if (!any_digit) {
+	       return false;
+	  }
+
+	  std::uint64_t scale(unit);
+	  if (str != end) {
+	       const std::size_t len(static_cast<std::size_t>(end - str));
+	       for (scale = 0; units->name != NULL && scale == 0; ++units) {
+		    if (std::strlen(units->name) == len
+			&& std::memcmp(units->name, str, len) == 0) {
+			 scale = units->scale;
+		    }
+	       }
+	       if (scale == 0) {
+		    return false;
+	       }
+	  }
+
+	  if (whole != 0 && scale > max_u64 / whole) {
+	       return false;
+	  }
+	  value = whole * scale;
+
+	  // frac * scale / den must be whole: reduce by gcd(scale, den) first
+	  // so that nothing overflows (the result is below scale)
+	  const std::uint64_t g(gcd(scale, den));
+	  if (frac % (den / g) != 0) {
+	       return false;
+	  }
+	  const std::uint64_t part(frac / (den / g) * (scale / g));
+	  if (part > max_u64 - value) {
+	       return false;
+	  }
+	  value += part;
+	  return true;
+     }
+}
+
+bool internal_::convert(const std::string& arg, ByteSize& value)
+{
+     std::uint64_t bytes(0);
+     if (!parse_quantity(arg, size_units, 1, bytes)) {
+	  return false;
+     }
+     value = ByteSize(bytes);
+     return true;
+}
+
+bool internal_::parse_duration(const std::string& arg,
+			       std::uint64_t unit_ns,
+			       std::uint64_t& ns)
+{
+     return parse_quantity(arg, duration_units, unit_ns, ns);
+}
+
+void ProgramOptionManager::set_parse_limits(const ParseLimits& limits)
+{
+     limits_ = limits;
+     limited_ = true;
+}
+
+void ProgramOptionManager::clear_parse_limits()
+{
+     limited_ = false;
+}
+
+ProgramOptionManager& ProgramOptionManager::add_static_options()
+{
+     static_options_ = true;
+     return *this;
+}
+
+void ProgramOptionManager::add_static_options_()
+{
+     if (!static_options_) {
+	  return;
+     }
+     static_options_ = false;
+
+     const std::size_t n_opts(opts_.size());
+     for (const internal_::StaticOption* it(internal_::StaticOption::first());
+	  it != NULL;
+	  it = it->next()) {
+	  const std::string s_name(it->short_name());
+	  const std::string l_name(it->long_name());
+	  bool used(false);
+	  for (std::size_t i(0); !used && i < n_opts; ++i) {
+	       used = ((!s_name.empty() && s_name == opts_[i]->short_name())
+		       || (!l_name.empty() && l_name == opts_[i]->long_name()));
+	  }
+	  if (!used) {
+	       opts_.push_back(it->make_option());
+	  }
+     }
+}
+
+void ProgramOptionManager::set_validation_threads(unsigned int n_threads)
+{
+     validation_threads_ = n_threads;
+     delete validation_pool_;
+     validation_pool_ = NULL;
+}
+
+int ProgramOptionManager::validate_()
+{
+     std::vector<internal_::ValidationTask> tasks;
+     for (std::size_t idx(0); idx < positionals_.size() + opts_.size(); ++idx) {
+	  option_at_(idx)->validation_tasks(tasks);
+     }
+     return run_validators_(tasks);
+}
+
+int ProgramOptionManager::run_validators_(std::vector<internal_::ValidationTask>& tasks)
+{
+     // the slowest checks (eg. stat() on network filesystems) are I/O bound:
+     // tasks are taken one by one from a shared counter
+     const std::size_t n_threads(validation_threads_ == 0
+				 ? std::max(1U, std::thread::hardware_concurrency())
+				 : validation_threads_);
+     if (n_threads == 1 || tasks.size() <= 2) {
+	  std::atomic<std::size_t> next(0);
+	  run_validation(tasks, next);
+     }
+     else {
+	  if (validation_pool_ == NULL) {
+	       validation_pool_ = new internal_::ValidationPool(n_threads - 1);
+	  }
+	  validation_pool_->run(tasks);
+     }
+
+     int retval(1);
+     for (std::size_t i(0); i < tasks.size(); ++i) {
+	  const internal_::ValidationTask& task(tasks[i]);
+	  if (task.error.empty()) {
+	       continue;
+	  }
+	  std::string name(display_name(task.option));
+	  if (task.element >= 0) {
+	       name += "[" + std::to_string(task.element) + "]";
+	  }
+	  report_("invalid value for " + name + ": " + task.error);
+	  if (retval > 0) {
+	       retval = fail_(ParseEvent::VALIDATION_FAILED, -1, task.option);
+	  }
+     }
+     return retval;
+}
+
+// -----------------------------------------------------------------------------
+
+int ProgramOptionManager::process_arguments(int argc, char** argv)
+{
+     finalize_();
+     error_ = ParseError();
+     if (cache_ == NULL) {
+	  presize_(argc, argv);
+	  ParseEventStream stream(*this, argc, argv);
+	  return parse_(stream);
+     }
+
+     internal_::ParseCache& cache(*cache_);
+
+     // Reset the bound targets that may have been modified by the last call
+     for (std::size_t idx(0); idx + 1 < cache.offsets.size(); ++idx) {
+	  OptionValueBase* opt(option_at_(idx));
+	  if (cache.all_dirty || opt->consumed() || cache.defaulted[idx]) {
+	       opt->restore_value(cache.baseline.data() + cache.offsets[idx],
+				  cache.baseline.data() + cache.offsets[idx+1]);
+	  }
+	  opt->reset();
+     }
+     cache.all_dirty = false;
+     std::fill(cache.defaulted.begin(), cache.defaulted.end(), 0);
+
+     std::uint64_t hash(14695981039346656037ULL);
+     for (int i(1); i < argc; ++i) {
+	  hash = hash_bytes(argv[i], std::strlen(argv[i]) + 1, hash);
+     }
+
+     typedef internal_::ParseCache::index_type::iterator index_iter;
+     std::pair<index_iter, index_iter> range(cache.index.equal_range(hash));
+     for (index_iter it(range.first); it != range.second; ++it) {
+	  const internal_::ParseCache::Entry& entry(*it->second);
+	  if (entry.argc != argc) {
+	       continue;
+	  }
+
+	  // verify byte-for-byte
+	  const char* key(entry.key.c_str());
+	  const char* key_end(key + entry.key.size());
+	  int i(1);
+	  for (; i < argc; ++i) {
+	       const std::size_t len(std::strlen(argv[i]) + 1);
+	       if (static_cast<std::size_t>(key_end - key) < len
+		   || std::memcmp(key, argv[i], len) != 0) {
+		    break;
+	       }
+	       key += len;
+	  }
+	  if (i != argc) {
+	       continue;
+	  }
+
+	  ++cache.hits;
+	  cache.entries.splice(cache.entries.begin(), cache.entries, it->second);
+	  return restore_records_(&entry.snapshot[0], entry.snapshot.size());
+     }
+
+     ++cache.misses;
+     presize_(argc, argv);
+     ParseEventStream stream(*this, argc, argv);
+     const int retval(parse_(stream));
+     if (retval <= 0) {
+	  cache.all_dirty = true;
+	  return retval;
+     }
+
+     internal_::ParseCache::Entry entry;
+     entry.hash = hash;
+     entry.argc = argc;
+     for (int i(1); i < argc; ++i) {
+	  entry.key.append(argv[i], std::strlen(argv[i]) + 1);
+     }
+     save_snapshot(entry.snapshot); // cannot fail, checked by enable_parse_cache()
+
+     cache.entries.push_front(entry);
+     cache.index.insert(std::make_pair(hash, cache.entries.begin()));
+
+     if (cache.entries.size() > cache.max_entries) {
+	  internal_::ParseCache::lru_type::iterator last(--cache.entries.end());
+	  range = cache.index.equal_range(last->hash);
+	  for (index_iter it(range.first); it != range.second; ++it) {
+	       if (it->second == last) {
+		    cache.index.erase(it);
+		    break;
+	       }
+	  }
+	  cache.entries.erase(last);
+     }
+     return retval;
+}
+
+// -----------------------------------------------------------------------------
+
+int ProgramOptionManager::process_arguments(int argc,
+					     char** argv,
+					     ArgumentSource& source)
+{
+     finalize_();
+     if (cache_ != NULL) {
+	  // arguments from the source may not be replayed
+	  cache_->all_dirty = true;
+     }
+     presize_(argc, argv);
+     ParseEventStream stream(*this, argc, argv, source);
+     return parse_(stream);
+}
+
+// -----------------------------------------------------------------------------
+
+int ProgramOptionManager::process_command_line(char* command)
+{
+     // the program name stays in the buffer, as argv[0]
+     CommandLineSource source(command);
+     std::size_t size(0);
+     char* argv[] = {source.next_word(size), NULL};
+     return process_arguments(1, argv, source);
+}
+
+int ProgramOptionManager::process_command_line(const std::string& command)
+{
+     std::vector<char> buffer(command.begin(), command.end());
+     buffer.push_back('\0');
+     return process_command_line(&buffer[0]);
+}
+
+// -----------------------------------------------------------------------------
+
+void ProgramOptionManager::set_overlay_base()
+{
+     finalize_();
+     if (overlay_ == NULL) {
+	  overlay_ = new internal_::Overlay;
+     }
+     internal_::Overlay& overlay(*overlay_);
+     overlay.discard();
+
+     const std::size_t n_options(positionals_.size() + opts_.size());
+     overlay.ids.clear();
+     for (std::size_t idx(0); idx < n_options; ++idx) {
+	  overlay.ids[option_at_(idx)] = idx;
+     }
+     overlay.overridden.assign(n_options, 0);
+     overlay.rules.assign(n_options, std::vector<std::size_t>());
+     if (constraints_ == NULL) {
+	  return;
+     }
+
+     internal_::ConstraintSet& set(*constraints_);
+     for (std::size_t r(0); r < set.rules.size(); ++r) {
+	  const internal_::ConstraintSet::Rule& rule(set.rules[r]);
+	  if (rule.subject != NULL) {
+	       overlay.rules[overlay.ids[rule.subject]].push_back(r);
+	  }
+	  for (std::size_t o(0); o < rule.options.size(); ++o) {
+	       std::vector<std::size_t>& rules(overlay.rules[overlay.ids[rule.options[o]]]);
+	       if (rules.empty() || rules.back() != r) {
+		    rules.push_back(r);
+	       }
+	  }
+     }
+     std::fill(set.seen.begin(), set.seen.end(), 0);
+     for (std::size_t idx(0); idx < n_options; ++idx) {
+	  if (option_at_(idx)->consumed()) {
+	       set.seen[idx / 64] |= std::uint64_t(1) << (idx % 64);
+	  }
+     }
+}
+
+int ProgramOptionManager::process_overlay(int argc, char** argv)
+{
+     if (overlay_ == NULL) {
+	  report_("no base to override (see set_overlay_base())");
+	  return -1;
+     }
+     clear_overlay();
+     error_ = ParseError();
+
+     ParseEventStream stream(*this, argc, argv);
+     stream.overlay_ = true;
+     const int retval(parse_(stream));
+     if (retval <= 0) {
+	  clear_overlay();
+     }
+     return retval;
+}
+
+void ProgramOptionManager::clear_overlay()
+{
+     if (overlay_ == NULL) {
+	  return;
+     }
+     internal_::Overlay& overlay(*overlay_);
+     for (std::size_t i(overlay.saved.size()); i-- > 0;) {
+	  const internal_::Overlay::Saved& saved(overlay.saved[i]);
+	  saved.option->restore_copy(saved.copy, saved.consumed);
+	  overlay.overridden[saved.id] = 0;
+	  if (constraints_ != NULL) {
+	       const std::uint64_t bit(std::uint64_t(1) << (saved.id % 64));
+	       std::uint64_t& word(constraints_->seen[saved.id / 64]);
+	       word = saved.consumed ? (word | bit) : (word & ~bit);
+	  }
+     }
+     overlay.saved.clear();
+}
+
+void ProgramOptionManager::override_(OptionValueBase* opt)
+{
+     internal_::Overlay& overlay(*overlay_);
+     const std::size_t id(overlay.ids[opt]);
+     if (overlay.overridden[id]) {
+	  return;
+     }
+     overlay.overridden[id] = 1;
+     const internal_::Overlay::Saved saved = {
+	  opt, id, opt->copy_value(), opt->consumed()
+     };
+     overlay.saved.push_back(saved);
+     opt->reset();
+     opt->clear_value();
+}
+
+int ProgramOptionManager::check_overlay_()
+{
+     internal_::Overlay& overlay(*overlay_);
+     std::vector<std::size_t> rules;
+     std::vector<internal_::ValidationTask> tasks;
+     for (std::size_t i(0); i < overlay.saved.size(); ++i) {
+	  const internal_::Overlay::Saved& saved(overlay.saved[i]);
+	  if (constraints_ != NULL) {
+	       const std::uint64_t bit(std::uint64_t(1) << (saved.id % 64));
+	       std::uint64_t& word(constraints_->seen[saved.id / 64]);
+	       word = saved.option->consumed() ? (word | bit) : (word & ~bit);
+	  }
+	  rules.insert(rules.end(),
+		       overlay.rules[saved.id].begin(),
+		       overlay.rules[saved.id].end());
+	  saved.option->validation_tasks(tasks);
+     }
+     std::sort(rules.begin(), rules.end());
+     rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+
+     int retval(1);
+     for (std::size_t r(0); r < rules.size(); ++r) {
+	  retval = check_rule_(rules[r], retval);
+     }
+     if (retval < 0) {
+	  return retval;
+     }
+     return run_validators_(tasks);
+}
+
+// -----------------------------------------------------------------------------
+
+int ProgramOptionManager::process_known_arguments(int argc,
+						   char** argv,
+						   PassthroughArguments& unknown)
+{
+     finalize_();
+     if (cache_ != NULL) {
+	  cache_->all_dirty = true;
+     }
+
+     presize_(argc, argv);
+     ParseEventStream stream(*this, argc, argv);
+     stream.stop_at_separator(true);
+
+     std::vector<char> known(argc, 0);
+     const int retval(parse_(stream, &known));
+     if (retval <= 0) {
+	  return retval;
+     }
+
+     // partially recognized arguments (eg. -bX with -b a flag) are errors
+     program_option_type unprocessed;
+     for (int i(1); i < argc; ++i) {
+	  if (known[i] == 3) {
+	       if (unprocessed.empty()) {
+		    fail_(ParseEvent::UNKNOWN_OPTION, i, NULL);
+	       }
+	       unprocessed.push_back(argv[i]);
+	  }
+     }
+     if (!unprocessed.empty()) {
+	  report_("some arguments I could not process:");
+	  report_(quote_args(unprocessed));
+	  return -1;
+     }
+
+     // everything after the separator is left to the caller
+     const int separator(static_cast<int>(stream.separator()));
+     if (separator > 0) {
+	  known[separator] = 1;
+	  std::fill(known.begin() + separator + 1, known.end(), 2);
+     }
+
+     // move the unrecognized arguments (pointers only) to the end of argv
+     std::vector<char*> passthrough;
+     char** out(argv + 1);
+     for (int i(1); i < argc; ++i) {
+	  if (known[i] == 2) {
+	       passthrough.push_back(argv[i]);
+	  }
+	  else {
+	       *out++ = argv[i];
+	  }
+     }
+     std::copy(passthrough.begin(), passthrough.end(), out);
+
+     unknown.begin_ = out;
+     unknown.end_ = argv + argc;
+     return retval;
+}
+
+// -----------------------------------------------------------------------------
+
+int ProgramOptionManager::parse_(ParseEventStream& stream, std::vector<char>* known)
+{
+     program_option_type unprocessed;
+     const OptionValueBase* missing(NULL);
+     error_ = ParseError();
+
+     ParseEvent event;
+     while (stream.next(event)) {
+	  if (known != NULL && event.token >= 0) {
+	       (*known)[event.token] |= (event.type == ParseEvent::PARSE_ERROR
+					 ? 2 : 1);
+	  }
+	  if (event.type != ParseEvent::PARSE_ERROR) {
+	       continue;
+	  }
+
+	  switch (event.error) {
+	  case ParseEvent::UNKNOWN_OPTION:
+	  case ParseEvent::UNEXPECTED_ARGUMENT:
+	       if (known == NULL) {
+		    if (unprocessed.empty()) {
+			 fail_(event.error, event.token, NULL);
+		    }
+		    unprocessed.push_back(stream.argument());
+	       }
+	       break;
+	  case ParseEvent::MISSING_REQUIRED:
+	       if (missing == NULL) {
+		    missing = event.option;
+	       }
+	       break;
+	  case ParseEvent::DUPLICATE_OPTION:
+	       report_(stream.argument() + " cannot be specified more than once");
+	       return fail_(event.error, event.token, event.option);
+	  case ParseEvent::MISSING_VALUE:
+	       report_("missing value(s) for the " + stream.argument()
+		       + " command line option");
+	       return fail_(event.error, event.token, event.option);
+	  case ParseEvent::INVALID_VALUE:
+	  {
+	       const std::string valid(event.option->valid_values());
+	       report_("invalid value '" + stream.argument()
+		       + "' for " + event.option->help_name()
+		       + (valid.empty() ? "" : " (valid values: " + valid + ")"));
+	       return fail_(event.error, event.token, event.option);
+	  }
+	  case ParseEvent::WRONG_COUNT:
+	       report_("wrong number of arguments for "
+		       + event.option->help_name());
+	       return fail_(event.error, event.token, event.option);
+	  case ParseEvent::INPUT_ERROR:
+	       report_("unable to read the arguments"
+		       + (stream.argument().empty()
+			  ? std::string() : ": " + stream.argument()));
+	       return fail_(event.error, event.token, NULL);
+	  case ParseEvent::LIMIT_EXCEEDED:
+	       report_("input rejected: " + stream.argument());
+	       return fail_(event.error, event.token, event.option);
+	  default:
+	       break;
+	  }
+     }
+
+     if (help_) {
+	  error_ = ParseError();
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+	  print_help();
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+	  return 0;
+     }
+     else if (!unprocessed.empty()) {
+	  report_("some arguments I could not process:");
+	  report_(quote_args(unprocessed));
+	  return -1;
+     }
+     else if (missing != NULL) {
+	  if (missing->short_name().empty() && missing->long_name().empty()) {
+	       report_("missing a value for: " + missing->help_name());
+	  }
+	  else {
+	       std::string opt_name(missing->long_name().empty()
+				    ? missing->help_name()
+				    : "--" + missing->long_name());
+	       report_("missing the " + opt_name + " command line option");
+	  }
+	  return fail_(ParseEvent::MISSING_REQUIRED, -1, missing);
+     }
+     else if (stream.overlay_) {
+	  return check_overlay_();
+     }
+     else if (check_constraints_() < 0 || validate_() < 0) {
+	  return -1;
+     }
+
+     apply_defaults_();
+     return 1;
+}
+
+// =============================================================================
+
+namespace {
+     /*
+      * Snapshot layout (host byte order):
+      *   char[8]  magic
+      *   uint32   format version
+      *   uint32   number of records
+      *   uint64   schema hash
+      * followed for each record by:
+      *   uint32   option index (positionals first, then named options)
+      *   uint32   payload size
+      *   char[]   payload (see internal_::binary_codec)
+      */
+     const char snapshot_magic[8] = {'A', 'R', 'G', 'P', 'S', 'N', 'A', 'P'};
+     const std::uint32_t snapshot_version = 1;
+     const std::size_t snapshot_header_size = 8 + 4 + 4 + 8;
+
+     //! FNV-1a hash
+     std::uint64_t fnv1a(const std::string& str, std::uint64_t hash)
+     {
+	  for (std::size_t i(0); i < str.size(); ++i) {
+	       hash ^= static_cast<unsigned char>(str[i]);
+	       hash *= 1099511628211ULL;
+	  }
+	  return hash;
+     }
+
+     template <typename T>
+     void write_raw(std::vector<char>& buffer, std::size_t pos, const T& t)
+     {
+	  std::memcpy(&buffer[pos], &t, sizeof(T));
+     }
+     template <typename T>
+     T read_raw(const char* data)
+     {
+	  T t;
+	  std::memcpy(&t, data, sizeof(T));
+	  return t;
+     }
+}
+
+// -----------------------------------------------------------------------------
+
+OptionValueBase* ProgramOptionManager::option_at_(std::size_t idx) const
+{
+     return idx < positionals_.size()
+	  ? positionals_[idx]
+	  : opts_[idx - positionals_.size()];
+}
+
+int ProgramOptionManager::option_id_(const OptionValueBase* opt) const
+{
+     const std::size_t n_options(positionals_.size() + opts_.size());
+     for (std::size_t idx(0); opt != NULL && idx < n_options; ++idx) {
+	  if (option_at_(idx) == opt) {
+	       return static_cast<int>(idx);
+	  }
+     }
+     return -1;
+}
+
+OptionValueBase* ProgramOptionManager::option_named_(const std::string& name)
 {
-     p->print_help_line();
+     add_static_options_();
+     for (const_iterator it(opts_.begin()) ; it < opts_.end() ; ++it) {
+	  if (name == (*it)->short_name() || name == (*it)->long_name()) {
+	       return *it;
+	  }
+     }
+     for (const_iterator it(positionals_.begin()) ; it < positionals_.end() ; ++it) {
+	  if (name == (*it)->help_name()) {
+	       return *it;
+	  }
+     }
+     return NULL;
 }
-void hn_op(const OptionValueBase* p)
+
+const OptionValueBase* ProgramOptionManager::option(int id) const
 {
-     std::cout << " " << p->help_name();
+     if (id < 0
+	 || static_cast<std::size_t>(id) >= positionals_.size() + opts_.size()) {
+	  return NULL;
+     }
+     return option_at_(id);
 }
-void sln_op(const OptionValueBase* p)
+
+// -----------------------------------------------------------------------------
+
+std::uint64_t ProgramOptionManager::schema_hash()
 {
-     std::cout << " " << p->usage_name();
+     finalize_();
+
+     std::uint64_t hash(14695981039346656037ULL);
+     for (const_iterator it(positionals_.begin()) ; it < positionals_.end() ; ++it) {
+	  hash = fnv1a((*it)->schema(), hash);
+     }
+     hash = fnv1a(std::string(1, '\0'), hash);
+     for (const_iterator it(opts_.begin()) ; it < opts_.end() ; ++it) {
+	  hash = fnv1a((*it)->schema(), hash);
+     }
+     return hash;
 }
 
 // -----------------------------------------------------------------------------
 
-bool hn_sort (OptionValueBase* a, OptionValueBase* b)
+bool ProgramOptionManager::save_snapshot(std::vector<char>& buffer)
 {
-     return a->help_name() < b->help_name();
+     const std::uint64_t hash(schema_hash());
+
+     buffer.assign(snapshot_header_size, 0);
+     std::memcpy(&buffer[0], snapshot_magic, sizeof(snapshot_magic));
+     write_raw(buffer, 8, snapshot_version);
+     write_raw(buffer, 16, hash);
+
+     std::uint32_t n_records(0);
+     for (std::size_t idx(0); idx < positionals_.size() + opts_.size(); ++idx) {
+	  const OptionValueBase* opt(option_at_(idx));
+	  if (!opt->consumed()) {
+	       continue;
+	  }
+
+	  const std::size_t record(buffer.size());
+	  buffer.resize(record + 8);
+	  if (!opt->save_value(buffer)) {
+	       report_("cannot serialize the value of " + opt->help_name());
+	       return false;
+	  }
+	  write_raw(buffer, record, static_cast<std::uint32_t>(idx));
+	  write_raw(buffer, record + 4,
+		    static_cast<std::uint32_t>(buffer.size() - record - 8));
+	  ++n_records;
+     }
+     write_raw(buffer, 12, n_records);
+     return true;
 }
 
-bool sln_sort (OptionValueBase* a, OptionValueBase* b)
+bool ProgramOptionManager::save_snapshot(const char* filename)
 {
-     if (a->short_name().empty()
-	 || b->short_name().empty()) {
-	  return a->long_name() < b->long_name();
+     std::vector<char> buffer;
+     if (!save_snapshot(buffer)) {
+	  return false;
      }
-     else {
-	  return a->short_name() < b->short_name();
+
+     std::FILE* out(std::fopen(filename, "wb"));
+     const bool ok(out != NULL
+		   && std::fwrite(&buffer[0], 1, buffer.size(), out) == buffer.size());
+     if (out == NULL || std::fclose(out) != 0 || !ok) {
+	  report_(std::string("unable to write snapshot to ") + filename);
+	  return false;
      }
+     return true;
 }
 
-// =============================================================================
+// -----------------------------------------------------------------------------
 
-class back_insert_args
+int ProgramOptionManager::restore_snapshot(const char* data, std::size_t size)
 {
-public:
-     back_insert_args(const std::vector<OptionValueBase*>& opts,
-		      program_option_type& argvv)
-	  : opts_(opts)
-	  , argvv_(argvv)
-	  {}
-     
-     void operator() (const std::string& arg)
-	  {
-	       for (unsigned int p(0); p < opts_.size(); ++p) {
-		    if (opts_[p]->match_short_name(arg)
-			&& arg.size() > 2) {
-			 argvv_.push_back(arg.substr(0,2));
-			 argvv_.push_back(arg.substr(2));
-			 return;
-		    }
-	       }
-	       argvv_.push_back(arg);
+     if (size < snapshot_header_size
+	 || std::memcmp(data, snapshot_magic, sizeof(snapshot_magic)) != 0
+	 || read_raw<std::uint32_t>(data + 8) != snapshot_version) {
+	  report_("invalid option snapshot!");
+	  return -1;
+     }
+     if (read_raw<std::uint64_t>(data + 16) != schema_hash()) {
+	  report_("option snapshot does not match the option schema!");
+	  return -1;
+     }
+
+     return restore_records_(data, size);
+}
+
+int ProgramOptionManager::restore_records_(const char* data, std::size_t size)
+{
+     const std::uint32_t n_records(read_raw<std::uint32_t>(data + 12));
+     const char* end(data + size);
+     const char* it(data + snapshot_header_size);
+     for (std::uint32_t r(0); r < n_records; ++r) {
+	  if (end - it < 8) {
+	       report_("truncated option snapshot!");
+	       return -1;
+	  }
+	  const std::uint32_t idx(read_raw<std::uint32_t>(it));
+	  const std::uint32_t payload(read_raw<std::uint32_t>(it + 4));
+	  it += 8;
+	  if (idx >= positionals_.size() + opts_.size()
+	      || static_cast<std::size_t>(end - it) < payload) {
+	       report_("corrupted option snapshot!");
+	       return -1;
+	  }
+
+	  OptionValueBase* opt(option_at_(idx));
+	  if (opt->restore_value(it, it + payload) != it + payload) {
+	       report_("corrupted value for " + opt->help_name()
+		       + " in option snapshot!");
+	       return -1;
 	  }
+	  it += payload;
+     }
+     if (check_constraints_() < 0 || validate_() < 0) {
+	  return -1;
+     }
+     apply_defaults_();
+     return 1;
+}
 
-private:
-     const std::vector<OptionValueBase*>& opts_;
-     program_option_type& argvv_;
-};
+int ProgramOptionManager::restore_snapshot(const char* filename)
+{
+     const void* data(NULL);
+     std::size_t size(0);
+     const std::shared_ptr<const void> file(internal_::map_file(filename,
+								  data, size));
+     if (!file) {
+	  report_(std::string("unable to open snapshot ") + filename);
+	  return -1;
+     }
+     return restore_snapshot(static_cast<const char*>(data), size);
+}
 
 // =============================================================================
 
-void print_argvv(const program_option_type& argvv)
+bool ProgramOptionManager::enable_parse_cache(std::size_t max_entries)
 {
-     std::cerr << "ERROR: ";
-     for (program_option_type::const_iterator it(argvv.begin())
-	       ; it != argvv.end() ; ++it) {
-	  std::cerr << "'" << *it << "' ";
+     finalize_();
+
+     delete cache_;
+     cache_ = NULL;
+     if (max_entries == 0) {
+	  return true;
      }
-     std::cerr << std::endl;
+
+     internal_::ParseCache* cache(new internal_::ParseCache(max_entries));
+     cache->offsets.push_back(0);
+     for (std::size_t idx(0); idx < positionals_.size() + opts_.size(); ++idx) {
+	  const OptionValueBase* opt(option_at_(idx));
+	  if (!opt->save_value(cache->baseline)) {
+	       report_("cannot enable the parse cache, the value of "
+		       + opt->help_name() + " cannot be serialized");
+	       delete cache;
+	       return false;
+	  }
+	  cache->offsets.push_back(cache->baseline.size());
+     }
+     cache->defaulted.assign(cache->offsets.size() - 1, 0);
+     cache_ = cache;
+     return true;
+}
+
+std::size_t ProgramOptionManager::parse_cache_hits() const
+{
+     return cache_ == NULL ? 0 : cache_->hits;
+}
+
+std::size_t ProgramOptionManager::parse_cache_misses() const
+{
+     return cache_ == NULL ? 0 : cache_->misses;
 }
 
 // =============================================================================
-     
-void ProgramOptionManager::usage()
+
+ParseEventStream::ParseEventStream(ProgramOptionManager& manager,
+				   int argc,
+				   char** argv)
+     : manager_(manager)
+     , argc_(argc)
+     , argv_(argv)
+     , source_(NULL)
+     , state_(PARSING)
+     , stop_at_separator_(false)
+     , separator_(-1)
+     , argi_(1)
+     , has_split_(false)
+     , split_index_(-1)
+     , has_lookahead_(false)
+     , lookahead_index_(-1)
+     , current_(NULL)
+     , current_index_(-1)
+     , position_(0)
+     , has_held_(false)
+     , held_index_(-1)
+     , overlay_(false)
+     , limits_(NULL)
+     , total_size_(0)
+     , file_arguments_(0)
+     , limit_index_(-1)
+{
+     manager_.finalize_();
+     apply_limits_();
+}
+
+ParseEventStream::ParseEventStream(ProgramOptionManager& manager,
+				   int argc,
+				   char** argv,
+				   ArgumentSource& source)
+     : manager_(manager)
+     , argc_(argc)
+     , argv_(argv)
+     , source_(&source)
+     , state_(PARSING)
+     , stop_at_separator_(false)
+     , separator_(-1)
+     , argi_(1)
+     , has_split_(false)
+     , split_index_(-1)
+     , has_lookahead_(false)
+     , lookahead_index_(-1)
+     , current_(NULL)
+     , current_index_(-1)
+     , position_(0)
+     , has_held_(false)
+     , held_index_(-1)
+     , overlay_(false)
+     , limits_(NULL)
+     , total_size_(0)
+     , file_arguments_(0)
+     , limit_index_(-1)
+{
+     manager_.finalize_();
+     apply_limits_();
+}
+
+// -----------------------------------------------------------------------------
+
+bool ParseEventStream::take_(std::string& arg, std::ptrdiff_t& index)
+{
+     if (has_lookahead_) {
+	  has_lookahead_ = false;
+	  arg.swap(lookahead_);
+	  index = lookahead_index_;
+	  return true;
+     }
+     if (has_split_) {
+	  has_split_ = false;
+	  arg.swap(split_);
+	  index = split_index_;
+	  return true;
+     }
+     if (!limit_error_.empty()) {
+	  return false;
+     }
+     if (argi_ < argc_) {
+	  arg = argv_[argi_];
+     }
+     else if (source_ == NULL || !source_->next(arg)) {
+	  return false;
+     }
+
+     index = argi_++;
+     if (limits_ != NULL && !check_limits_(arg, index)) {
+	  return false;
+     }
+     if (separator_ < 0
+	 && arg.size() > 2 && arg[0] == '-' && arg[1] != '-'
+	 && manager_.find_option_(arg.substr(0, 2)) != NULL) {
+	  split_.assign(arg, 2, std::string::npos);
+	  split_index_ = index;
+	  has_split_ = true;
+	  arg.resize(2);
+     }
+     return true;
+}
+
+void ParseEventStream::apply_limits_()
+{
+     if (!manager_.limited_) {
+	  return;
+     }
+     limits_ = &manager_.limits_;
+     if (source_ != NULL) {
+	  source_->set_max_argument_size(limits_->max_argument_size);
+     }
+
+     const std::vector<OptionValueBase*>& opts(manager_.opts_);
+     occurrences_.reserve(opts.size());
+     for (std::size_t i(0); i < opts.size(); ++i) {
+	  occurrences_.push_back(std::make_pair(opts[i], 0));
+     }
+     std::sort(occurrences_.begin(), occurrences_.end());
+}
+
+bool ParseEventStream::check_limits_(const std::string& arg,
+				     std::ptrdiff_t index)
+{
+     total_size_ += arg.size();
+     if (static_cast<std::size_t>(index) > limits_->max_arguments) {
+	  limit_error_ = "too many arguments";
+     }
+     else if (arg.size() > limits_->max_argument_size) {
+	  limit_error_ = "argument too long";
+     }
+     else if (total_size_ > limits_->max_total_size) {
+	  limit_error_ = "arguments too long in total";
+     }
+     else if ((internal_::is_file_arg(arg)
+	       || (arg.size() > 2 && arg[0] == '-' && arg[1] != '-'
+		   && arg.compare(2, 6, "@file:") == 0))
+	      && ++file_arguments_ > limits_->max_file_arguments) {
+	  limit_error_ = "too many @file: arguments";
+     }
+     else {
+	  return true;
+     }
+     limit_index_ = index;
+     return false;
+}
+
+bool ParseEventStream::check_occurrence_(const OptionValueBase* opt)
+{
+     typedef std::pair<const OptionValueBase*, std::size_t> entry;
+     std::vector<entry>::iterator it(
+	  std::lower_bound(occurrences_.begin(), occurrences_.end(),
+			   entry(opt, 0)));
+     return it != occurrences_.end() && it->first == opt
+	  && ++it->second <= limits_->max_occurrences;
+}
+
+bool ParseEventStream::limit_event_(ParseEvent& event)
 {
-     std::cout << "usage: " << prog_name_;
-     std::for_each(positionals_.begin(), positionals_.end(), hn_op);
-     std::for_each(opts_.begin(), opts_.end(), sln_op);
-     std::cout << std::endl;
+     const OptionValueBase* opt(current_);
+     state_ = DONE;
+     current_ = NULL;
+     argument_ = limit_error_;
+     return make_event_(event, ParseEvent::PARSE_ERROR,
+			ParseEvent::LIMIT_EXCEEDED, opt, limit_index_);
 }
 
-void ProgramOptionManager::print_help()
+bool ParseEventStream::peek_()
 {
-     usage();
-     if (!desc_.empty()) {
-	  std::cout << std::endl << desc_ << std::endl;
+     if (!has_lookahead_) {
+	  has_lookahead_ = take_(lookahead_, lookahead_index_);
      }
-     std::cout << "\nList of options:\n";
-     std::for_each(positionals_.begin(), positionals_.end(), phl_op);
-     std::for_each(opts_.begin(), opts_.end(), phl_op);
-     std::cout << std::endl;
+     return has_lookahead_;
 }
 
 // -----------------------------------------------------------------------------
 
-int ProgramOptionManager::process_arguments(int argc, char** argv)
+bool ParseEventStream::make_event_(ParseEvent& event,
+				   ParseEvent::TYPE type,
+				   ParseEvent::ERROR_CODE error,
+				   const OptionValueBase* option,
+				   std::ptrdiff_t token)
 {
-     bool help(false);
-     add_option("h", "help", help, "Show this help and exit");
+     event.type = type;
+     event.error = error;
+     event.option = option;
+     event.token = token;
+     return true;
+}
 
-     // std::sort(positionals_.begin(), positionals_.end(), hn_sort);
-     std::sort(opts_.begin(), opts_.end(), sln_sort);
+// -----------------------------------------------------------------------------
 
-     program_option_type argvv;
-     std::for_each(argv+1, argv + argc, back_insert_args(opts_, argvv));
+bool ParseEventStream::dispatch_positional_(const std::string& arg,
+					    std::ptrdiff_t index,
+					    ParseEvent& event)
+{
+     std::vector<OptionValueBase*>& positionals(manager_.positionals_);
+     if (overlay_) {
+	  // positional values of the base cannot be overridden
+	  argument_ = arg;
+	  return make_event_(event, ParseEvent::PARSE_ERROR,
+			     ParseEvent::UNEXPECTED_ARGUMENT, NULL, index);
+     }
+     while (position_ < positionals.size()
+	    && positionals[position_]->expected_values() == 0) {
+	  ++position_;
+     }
+     if (position_ == positionals.size()) {
+	  argument_ = arg;
+	  return make_event_(event, ParseEvent::PARSE_ERROR,
+			     ParseEvent::UNEXPECTED_ARGUMENT, NULL, index);
+     }
 
-     for (unsigned int p(0); p < opts_.size(); ++p) {
-	  if (!opts_[p]->consume(argvv)) {
-	       std::cerr << "ERROR: something bad happened while parsing named arguments!:\n";
-	       print_argvv(argvv);
-	       return -1;
+     OptionValueBase* opt(positionals[position_]);
+     argument_ = arg;
+     if (opt->skips_last()) {
+	  // the held argument is not the last one: give it to opt
+	  if (!has_held_) {
+	       has_held_ = true;
+	       held_ = arg;
+	       held_index_ = index;
+	       return false;
 	  }
+	  argument_.swap(held_);
+	  std::swap(index, held_index_);
      }
 
-     for (unsigned int p(0); p < positionals_.size(); ++p) {
-	  positionals_[p]->consume(argvv); // cannot fail
+     if (!opt->consume_value(argument_)) {
+	  return make_event_(event, ParseEvent::PARSE_ERROR,
+			     ParseEvent::INVALID_VALUE, opt, index);
      }
+     return make_event_(event, ParseEvent::POSITIONAL_VALUE,
+			ParseEvent::NONE, opt, index);
+}
 
-     if (help) {
-	  print_help();
-	  return 0;
+// -----------------------------------------------------------------------------
+
+bool ParseEventStream::next(ParseEvent& event)
+{
+     std::vector<OptionValueBase*>& positionals(manager_.positionals_);
+     std::string arg;
+     std::ptrdiff_t index(-1);
+
+     while (state_ == PARSING) {
+	  if (current_ != NULL) {
+	       if (current_->expected_values() != 0
+		   && peek_()
+		   && (lookahead_.empty() || lookahead_[0] != '-')) {
+		    take_(argument_, index);
+		    if (!current_->consume_value(argument_)) {
+			 OptionValueBase* opt(current_);
+			 current_ = NULL;
+			 return make_event_(event, ParseEvent::PARSE_ERROR,
+					    ParseEvent::INVALID_VALUE, opt, index);
+		    }
+		    return make_event_(event, ParseEvent::VALUE_CONVERTED,
+				       ParseEvent::NONE, current_, index);
+	       }
+	       if (!limit_error_.empty()) {
+		    return limit_event_(event);
+	       }
+	       if (source_ != NULL && source_->failed()) {
+		    // reported below rather than as missing values
+		    current_ = NULL;
+		    continue;
+	       }
+
+	       OptionValueBase* opt(current_);
+	       current_ = NULL;
+	       if (!opt->complete()) {
+		    argument_ = current_name_;
+		    return make_event_(event, ParseEvent::PARSE_ERROR,
+				       ParseEvent::MISSING_VALUE, opt,
+				       current_index_);
+	       }
+	  }
+
+	  if (!take_(arg, index)) {
+	       if (!limit_error_.empty()) {
+		    return limit_event_(event);
+	       }
+	       state_ = COMPLETING;
+	       if (source_ != NULL && source_->failed()) {
+		    argument_ = source_->error();
+		    return make_event_(event, ParseEvent::PARSE_ERROR,
+				       ParseEvent::INPUT_ERROR, NULL, -1);
+	       }
+	       break;
+	  }
+
+	  if (arg.empty() || arg[0] != '-' || separator_ >= 0) {
+	       if (dispatch_positional_(arg, index, event)) {
+		    return true;
+	       }
+	       continue;
+	  }
+
+	  if (arg == "--") {
+	       separator_ = index;
+	       argument_.swap(arg);
+	       if (stop_at_separator_) {
+		    state_ = COMPLETING;
+	       }
+	       return make_event_(event, ParseEvent::END_OF_OPTIONS,
+				  ParseEvent::NONE, NULL, index);
+	  }
+
+	  argument_.swap(arg);
+	  OptionValueBase* opt(manager_.find_option_(argument_));
+	  if (opt == NULL) {
+	       return make_event_(event, ParseEvent::PARSE_ERROR,
+				  ParseEvent::UNKNOWN_OPTION, NULL, index);
+	  }
+	  if (limits_ != NULL && !check_occurrence_(opt)) {
+	       limit_error_ = "too many occurrences of " + argument_;
+	       limit_index_ = index;
+	       current_ = opt;
+	       return limit_event_(event);
+	  }
+	  if (overlay_) {
+	       manager_.override_(opt);
+	  }
+	  if (!opt->match()) {
+	       return make_event_(event, ParseEvent::PARSE_ERROR,
+				  ParseEvent::DUPLICATE_OPTION, opt, index);
+	  }
+	  current_ = opt;
+	  current_index_ = index;
+	  current_name_ = argument_;
+	  return make_event_(event, ParseEvent::OPTION_MATCHED,
+			     ParseEvent::NONE, opt, index);
      }
-     else if (!argvv.empty()) {
-	  std::cerr << "ERROR: some arguments I could not process:" << std::endl;
 
-	  print_argvv(argvv);
-	  return -1;
+     if (overlay_ && state_ != PARSING) {
+	  // the base is complete: only the overrides are checked
+	  state_ = DONE;
      }
-     else {
-	  for (const_iterator it(positionals_.begin()) ;
-	       it < positionals_.end() ; ++it) {
-	       if ((*it)->required() && !(*it)->consumed()) {
-		    std::cerr << "ERROR: missing a value for: "
-			      << (*it)->help_name()
-			      << std::endl;
-		    return -1;
+
+     if (state_ == COMPLETING) {
+	  if (has_held_) {
+	       // the last argument goes to the next positional
+	       has_held_ = false;
+	       ++position_;
+	       if (dispatch_positional_(held_, held_index_, event)) {
+		    return true;
 	       }
 	  }
-	  
-	  for (const_iterator it(opts_.begin()) ;
-	       it < opts_.end() ; ++it) {
-	       if ((*it)->required() && !(*it)->consumed()) {
-		    std::string opt_name((*it)->long_name().empty()
-					 ? (*it)->help_name()
-					 : "--" + (*it)->long_name());
-		    std::cerr << "ERROR: missing the "
-			      << opt_name
-			      << " command line option"
-			      << std::endl;
-		    return -1;
+
+	  state_ = CHECKING_REQUIRED;
+	  for (std::size_t p(0); p < positionals.size(); ++p) {
+	       if (!positionals[p]->complete()) {
+		    argument_ = positionals[p]->help_name();
+		    return make_event_(event, ParseEvent::PARSE_ERROR,
+				       ParseEvent::WRONG_COUNT,
+				       positionals[p], -1);
 	       }
 	  }
+	  position_ = 0;
      }
 
-     return 1;
-}     
+     if (state_ == CHECKING_REQUIRED) {
+	  const std::size_t n_positionals(positionals.size());
+	  for (; position_ < n_positionals + manager_.opts_.size(); ++position_) {
+	       const OptionValueBase* opt(manager_.option_at_(position_));
+	       if (opt->required() && !opt->consumed()) {
+		    ++position_;
+		    argument_ = opt->help_name();
+		    return make_event_(event, ParseEvent::PARSE_ERROR,
+				       ParseEvent::MISSING_REQUIRED, opt, -1);
+	       }
+	  }
+	  state_ = DONE;
+     }
+     return false;
+}
+
+// =============================================================================
+
+FdArgumentSource::FdArgumentSource(int fd,
+				   char delimiter,
+				   std::size_t chunk_size)
+     : fd_(fd)
+     , delimiter_(delimiter)
+     , buffer_(std::max<std::size_t>(1, chunk_size))
+     , begin_(0)
+     , end_(0)
+     , offset_(0)
+     , eof_(false)
+     , failed_(false)
+     , utf8_check_(false)
+     , utf8_error_(utf8_valid)
+     , max_argument_size_(std::numeric_limits<std::size_t>::max())
+{}
+
+bool FdArgumentSource::fill_()
+{
+     if (eof_) {
+	  return false;
+     }
+
+     for (;;) {
+#ifdef _WIN32
+	  const long n(::_read(fd_, &buffer_[0],
+			       static_cast<unsigned int>(buffer_.size())));
+#else
+	  const long n(::read(fd_, &buffer_[0], buffer_.size()));
+#endif /* _WIN32 */
+	  if (n > 0) {
+	       offset_ += end_;
+	       begin_ = 0;
+	       end_ = n;
+	       return true;
+	  }
+	  if (n < 0 && errno == EINTR) {
+	       continue;
+	  }
+	  failed_ = (n < 0);
+	  eof_ = true;
+	  return false;
+     }
+}
+
+bool FdArgumentSource::next(std::string& arg)
+{
+     arg.clear();
+     const std::size_t start(offset_ + begin_);
+     bool has_data(false);
+     for (;;) {
+	  if (begin_ == end_ && !fill_()) {
+	       // last argument may not be terminated
+	       if (!has_data || failed_) {
+		    return false;
+	       }
+	       break;
+	  }
+
+	  const char* begin(&buffer_[0] + begin_);
+	  const char* delim(static_cast<const char*>(
+				 std::memchr(begin, delimiter_, end_ - begin_)));
+	  if (delim != NULL) {
+	       arg.append(begin, delim);
+	       begin_ += (delim - begin) + 1;
+	       break;
+	  }
+	  arg.append(begin, end_ - begin_);
+	  begin_ = end_;
+	  has_data = true;
+	  if (arg.size() > max_argument_size_) {
+	       // rejected anyway: stop buffering it (and reading)
+	       arg.resize(max_argument_size_ + 1);
+	       eof_ = true;
+	       return true;
+	  }
+     }
+
+     if (utf8_check_) {
+	  const std::size_t error(utf8_error(arg.data(), arg.size()));
+	  if (error != utf8_valid) {
+	       utf8_error_ = start + error;
+	       failed_ = true;
+	       eof_ = true;
+	       return false;
+	  }
+     }
+     return true;
+}
+
+std::string FdArgumentSource::error() const
+{
+     if (utf8_error_ != utf8_valid) {
+	  return "invalid UTF-8 at byte " + std::to_string(utf8_error_);
+     }
+     return std::string();
+}
+
+// =============================================================================
+
+namespace {
+     bool is_blank(char c)
+     {
+	  return c == ' ' || c == '\t' || c == '\n';
+     }
+}
+
+CommandLineSource::CommandLineSource(char* command)
+     : read_(command)
+     , write_(command)
+     , error_(NULL)
+{}
+
+char* CommandLineSource::next_word(std::size_t& size)
+{
+     while (error_ == NULL && is_blank(*read_)) {
+	  ++read_;
+     }
+     if (error_ != NULL || *read_ == '\0') {
+	  return NULL;
+     }
+
+     // the unquoted word is never longer than its quoted form, so it is
+     // written over the part of the buffer already read
+     write_ = read_;
+     char* const word(write_);
+     while (*read_ != '\0' && !is_blank(*read_)) {
+	  const char c(*read_++);
+	  if (c == '\\') {
+	       if (*read_ == '\n') {
+		    ++read_;
+	       }
+	       else if (*read_ != '\0') {
+		    *write_++ = *read_++;
+	       }
+	       else {
+		    *write_++ = c;
+	       }
+	  }
+	  else if (c == '\'') {
+	       while (*read_ != '\0' && *read_ != '\'') {
+		    *write_++ = *read_++;
+	       }
+	       if (*read_ == '\0') {
+		    error_ = "unterminated single quote";
+		    return NULL;
+	       }
+	       ++read_;
+	  }
+	  else if (c == '"') {
+	       while (*read_ != '\0' && *read_ != '"') {
+		    if (*read_ == '\\' && read_[1] == '\n') {
+			 read_ += 2;
+			 continue;
+		    }
+		    if (*read_ == '\\'
+			&& (read_[1] == '$' || read_[1] == '`'
+			    || read_[1] == '"' || read_[1] == '\\')) {
+			 ++read_;
+		    }
+		    *write_++ = *read_++;
+	       }
+	       if (*read_ == '\0') {
+		    error_ = "unterminated double quote";
+		    return NULL;
+	       }
+	       ++read_;
+	  }
+	  else {
+	       *write_++ = c;
+	  }
+     }
+
+     // write_ < read_ unless the word ends the command line, where the
+     // terminating NUL is overwritten by itself
+     const bool end(*read_ == '\0');
+     *write_ = '\0';
+     if (!end) {
+	  ++read_;
+     }
+     size = write_ - word;
+     return word;
+}
+
+bool CommandLineSource::next(std::string& arg)
+{
+     std::size_t size(0);
+     const char* word(next_word(size));
+     if (word == NULL) {
+	  return false;
+     }
+     arg.assign(word, size);
+     return true;
+}
+
+std::string CommandLineSource::error() const
+{
+     return error_ == NULL ? std::string() : std::string(error_);
+}
@@ -0,0 +1,216 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+#ifndef PROGRAM_OPTIONS_BATCH_HPP_INCLUDED
+#define PROGRAM_OPTIONS_BATCH_HPP_INCLUDED
+
+#include "program_options.hpp"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+//! Class parsing many command lines in parallel against one option schema
+/** Each worker thread owns a single ProgramOptionManager (bound to a
+ *  thread-local T by the user-supplied binder function) which is reset and
+ *  reused for every command line it processes, so the cost of building the
+ *  schema is paid once per thread instead of once per command line.
+ *
+ *  Command lines are split into chunks distributed over per-thread work
+ *  queues; idle threads steal chunks from the back of the other queues.
+ */
+template <typename T>
+class BatchParser
+{
+public:
+     //! Function binding the members of a T to the options of a manager
+     typedef void (*binder_type)(ProgramOptionManager&, T&);
+     //! Arguments of a single command line (without program name)
+     typedef internal_::program_option_type argument_list;
+
+     //! Outcome of parsing a single command line
+     struct Result
+     {
+	  //! Same as ProgramOptionManager::process_arguments()
+	  int retval;
+	  //! Parsed values
+	  T value;
+	  //! Error messages (empty if none, always empty without iostreams)
+	  std::string error;
+	  //! Structured error (see ProgramOptionManager::last_error())
+	  ParseError parse_error;
+	  //! Help printed (empty if none, always empty without iostreams)
+	  std::string output;
+     };
+
+     //! Constructor
+     /** \param prog_name Program name used for each underlying manager
+      *  \param desc Program description used for each underlying manager
+      *  \param binder Function registering the options for a given T
+      *  \param defaults Initial value of T before each parse
+      *  \param n_threads Number of worker threads (0 to use all cores)
+      */
+     BatchParser(const char* prog_name,
+		 const char* desc,
+		 binder_type binder,
+		 const T& defaults = T(),
+		 unsigned int n_threads = 0)
+	  : prog_name_(prog_name)
+	  , desc_(desc)
+	  , binder_(binder)
+	  , defaults_(defaults)
+	  , n_threads_(n_threads == 0
+		       ? std::max(1U, std::thread::hardware_concurrency())
+		       : n_threads)
+	  {}
+
+     //! Parse all the command lines
+     /** \param lines Command lines to parse
+      *  \param chunk_size Number of consecutive command lines per work item
+      *  \return One result per command line, in the same order
+      */
+     std::vector<Result> parse(const std::vector<argument_list>& lines,
+			       std::size_t chunk_size = 256) const
+	  {
+	       Result empty = {0, defaults_, std::string(), ParseError(),
+				std::string()};
+	       std::vector<Result> results(lines.size(), empty);
+	       if (lines.empty()) {
+		    return results;
+	       }
+
+	       chunk_size = std::max<std::size_t>(1, chunk_size);
+	       const std::size_t n_chunks((lines.size() + chunk_size - 1)
+					  / chunk_size);
+	       const std::size_t n_workers(std::min<std::size_t>(n_threads_,
+								  n_chunks));
+
+	       std::vector<WorkQueue> queues(n_workers);
+	       for (std::size_t c(0); c < n_chunks; ++c) {
+		    const std::size_t begin(c * chunk_size);
+		    queues[c * n_workers / n_chunks].chunks.push_back(
+			 range_type(begin, std::min(begin + chunk_size,
+						    lines.size())));
+	       }
+
+	       std::vector<std::thread> threads;
+	       for (std::size_t w(1); w < n_workers; ++w) {
+		    threads.push_back(std::thread(&BatchParser::work_, this, w,
+						  std::ref(queues),
+						  std::cref(lines),
+						  std::ref(results)));
+	       }
+	       work_(0, queues, lines, results);
+	       for (std::size_t w(0); w < threads.size(); ++w) {
+		    threads[w].join();
+	       }
+	       return results;
+	  }
+
+private:
+     typedef std::pair<std::size_t, std::size_t> range_type;
+
+     //! Work queue of a single thread
+     struct WorkQueue
+     {
+	  bool pop_front(range_type& range)
+	       {
+		    std::lock_guard<std::mutex> lock(mutex);
+		    if (chunks.empty()) {
+			 return false;
+		    }
+		    range = chunks.front();
+		    chunks.pop_front();
+		    return true;
+	       }
+	  bool steal_back(range_type& range)
+	       {
+		    std::lock_guard<std::mutex> lock(mutex);
+		    if (chunks.empty()) {
+			 return false;
+		    }
+		    range = chunks.back();
+		    chunks.pop_back();
+		    return true;
+	       }
+
+	  std::mutex mutex;
+	  std::deque<range_type> chunks;
+     };
+
+     //! Main loop of a worker thread
+     void work_(std::size_t worker,
+		std::vector<WorkQueue>& queues,
+		const std::vector<argument_list>& lines,
+		std::vector<Result>& results) const
+	  {
+	       T value(defaults_);
+	       ProgramOptionManager manager(prog_name_.c_str(), desc_.c_str());
+	       binder_(manager, value);
+
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+	       std::ostringstream err;
+	       std::ostringstream out;
+	       manager.set_error_stream(err);
+	       manager.set_output_stream(out);
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+	       std::vector<char*> argv;
+	       range_type range;
+	       while (next_(worker, queues, range)) {
+		    for (std::size_t l(range.first); l < range.second; ++l) {
+			 value = defaults_;
+			 manager.reset();
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+			 err.str("");
+			 out.str("");
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+			 // process_arguments() never modifies its arguments
+			 argv.assign(1, const_cast<char*>(prog_name_.c_str()));
+			 for (std::size_t i(0); i < lines[l].size(); ++i) {
+			      argv.push_back(const_cast<char*>(lines[l][i].c_str()));
+			 }
+
+			 results[l].retval = manager.process_arguments(argv.size(),
+								       &argv[0]);
+			 results[l].value = value;
+			 results[l].parse_error = manager.last_error();
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+			 results[l].error = err.str();
+			 results[l].output = out.str();
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+		    }
+	       }
+	  }
+
+     //! Get the next chunk to process, stealing from other threads if needed
+     static bool next_(std::size_t worker,
+		       std::vector<WorkQueue>& queues,
+		       range_type& range)
+	  {
+	       if (queues[worker].pop_front(range)) {
+		    return true;
+	       }
+	       for (std::size_t i(1); i < queues.size(); ++i) {
+		    if (queues[(worker + i) % queues.size()].steal_back(range)) {
+			 return true;
+		    }
+	       }
+	       return false;
+	  }
+
+     std::string prog_name_;
+     std::string desc_;
+     binder_type binder_;
+     T defaults_;
+     unsigned int n_threads_;
+};
+
+#endif //PROGRAM_OPTIONS_BATCH_HPP_INCLUDED
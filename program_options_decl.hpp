@@ -0,0 +1,2128 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+#ifndef PROGRAM_OPTIONS_DECL_HPP_INCLUDED
+#define PROGRAM_OPTIONS_DECL_HPP_INCLUDED
+
+/*
+ * Declarations of the option manager. This header does not define the
+ * option templates: include program_options.hpp (or program_options_impl.hpp)
+ * to bind values of types other than bool, int, unsigned int, double,
+ * std::string and vectors of these.
+ */
+
+/*
+ * Defining PROGRAM_OPTIONS_NO_IOSTREAM removes every use of iostreams: values
+ * are converted with the strto* functions (only arithmetic types and strings
+ * are supported, see internal_::convert), errors are only reported through
+ * ProgramOptionManager::last_error() and help has to be rendered by the
+ * caller (see ProgramOptionManager::help_text()).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+#  include <iosfwd>
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+namespace internal_ {
+     enum DEPENDENT_FUNCTION {
+	  UINT_ASSIGN,
+	  BITCOUNT_ASSIGN,
+	  INVALID_FUNC
+     };
+     
+     // ------------------------------------------------------------------------
+     
+     inline unsigned int bitcount(unsigned int flags)
+     {
+	  unsigned int N(0);
+	  
+	  for (; flags > 0; ++N) {
+	       flags &= (flags - 1);
+	  }
+	  return N;
+     }
+
+     // ========================================================================
+
+     typedef std::vector<std::string> program_option_type;
+
+     // ========================================================================
+
+     class OptionValueBase;
+
+     //! Check of a single value run after parsing (see Validator)
+     struct ValidationTask
+     {
+	  //! Check returning an error message (empty if the value is valid)
+	  const std::function<std::string (const void*)>* check;
+	  const void* value;
+	  const OptionValueBase* option;
+	  //! Index of the value in vector targets (-1 for scalars)
+	  std::ptrdiff_t element;
+	  std::string error;
+     };
+
+     // ------------------------------------------------------------------------
+
+     //! Base class for all options
+     /** Options are basically defined by:
+      *    - short name:  typically one char (may be empty)
+      *    - long name:   longer more meaningful name
+      *    - help name:   named used for the value in the help output
+      *                   (similar to Python.argparse)
+      */
+     class OptionValueBase
+     {
+     public:
+	  //! Size of first column in help output
+	  enum {HELP_PAD = 40};
+     
+	  //! Constructor for flags and values options
+	  /** \param short_name Short name for the option (without leading -)
+	   *  \param long_name Long name for the option (without leading --)
+	   *  \param desc Description of the option
+	   *  \param required Whether the option must be present or not
+	   *
+	   * Long name will be used as help name
+	   */
+	  OptionValueBase(const char* short_name,
+			  const char* long_name,
+			  const char* desc,
+			  bool required)
+	       : short_name_(short_name)
+	       , long_name_(long_name)
+	       , help_name_(long_name)
+	       , desc_(desc)
+	       , consumed_(false)
+	       , required_(required)
+	       {}
+     
+	  //! Constructor for flags and value options with user-defined help name
+	  /** \param short_name Short name for the option (without leading -)
+	   *  \param long_name Long name for the option (without leading --)
+	   *  \param help_name Name to display in the help output
+	   *  \param desc Description of the option
+	   *  \param required Whether the option must be present or not
+	   */
+	  OptionValueBase(const char* short_name,
+			  const char* long_name,
+			  const char* help_name,
+			  const char* desc,
+			  bool required)
+	       : short_name_(short_name)
+	       , long_name_(long_name)
+	       , help_name_(help_name)
+	       , desc_(desc)
+	       , consumed_(false)
+	       , required_(required)
+	       {}
+
+	  //! Constructor for positional options (ie. without short or long names)
+	  /** \param help_name Name of the option
+	   *  \param desc Description of the option
+	   *  \param required Whether the option must be present or not
+	   */
+	  OptionValueBase(const char* help_name,
+			  const char* desc,
+			  bool required)
+	       : short_name_()
+	       , long_name_()
+	       , help_name_(help_name)
+	       , desc_(desc)
+	       , consumed_(false)
+	       , required_(required)
+	       {}
+
+	  //! Destructor
+	  virtual ~OptionValueBase() {}
+
+	  //! Called when the name of the option is found on the command line
+	  /** \return False if the option cannot be specified (again)
+	   */
+	  virtual bool match() { return !consumed_; }
+
+	  //! Number of values the option still accepts (-1 if unlimited)
+	  virtual int expected_values() = 0;
+
+	  //! Convert and store one value
+	  /** \param arg Argument to convert
+	   *  \return False if the conversion failed
+	   */
+	  virtual bool consume_value(const std::string& arg) = 0;
+
+	  //! Called once no more values are available for the option
+	  /** For named options, this is called after the values following each
+	   *  occurrence of the option; for positional options, once at the end
+	   *  of parsing.
+	   *  \return False if the values received are incomplete
+	   */
+	  virtual bool complete() { return true; }
+
+	  //! Whether the last positional argument is left to the next positional
+	  virtual bool skips_last() const { return false; }
+
+	  //! Reset the parsing state of the option (bound value is untouched)
+	  virtual void reset() { consumed_ = false; }
+
+	  //! Heap-allocated copy of the bound value (NULL if not supported)
+	  virtual void* copy_value() const { return NULL; }
+	  //! Assign a copy made by copy_value() back to the bound value
+	  /** \param copy Copy of the value (destroyed)
+	   *  \param consumed Whether the option is marked as consumed
+	   */
+	  virtual void restore_copy(void* copy, bool consumed)
+	       {
+		    (void) copy;
+		    consumed_ = consumed;
+	       }
+	  //! Destroy a copy made by copy_value() without using it
+	  virtual void destroy_copy(void* copy) const { (void) copy; }
+	  //! Remove all the values of a multi-valued target
+	  virtual void clear_value() {}
+
+	  //! Checks whether an argument has been consumed or not
+	  bool consumed() const { return consumed_; }
+	  //! Checks whether an argument is required or not
+	  bool required() const { return required_; }
+
+	  //! Names (and values) shown in the first column of the help output
+	  virtual std::string help_entry() const = 0;
+	  //! Additional line shown in the help output (empty if none)
+	  virtual std::string help_note() const { return std::string(); }
+	  //! Comma-separated list of the accepted values (empty if any value)
+	  virtual std::string valid_values() const { return std::string(); }
+
+	  const std::string& short_name() const { return short_name_; }
+	  const std::string& long_name()  const { return long_name_;  }
+	  const std::string& help_name()  const { return help_name_;  }
+	  const std::string& desc()       const { return desc_;       }
+
+	  virtual std::string usage_name() const
+	       {
+		    std::string ret("[-");
+		    if (!short_name_.empty()) {
+			 ret += short_name_ + "]";
+		    }
+		    else {
+			 ret += "-" + long_name_ + "]";
+		    }
+		    return ret;
+	       }
+
+	  //! Description of the option used to compute the schema hash
+	  /** Includes the dynamic type of the option (and thus the type of the
+	   *  bound value) as well as its names.
+	   */
+	  virtual std::string schema() const
+	       {
+		    return std::string(typeid(*this).name())
+			 + '\0' + short_name_
+			 + '\0' + long_name_
+			 + '\0' + help_name_
+			 + (required_ ? "\1" : "\0");
+	       }
+
+	  //! Appends the binary representation of the bound value to out
+	  /** \return False if the type of the value cannot be serialized
+	   */
+	  virtual bool save_value(std::vector<char>& out) const = 0;
+	  //! Restores the bound value from its binary representation
+	  /** \return Pointer past the data read or NULL if an error is detected
+	   *  \note On success, the option is marked as consumed
+	   */
+	  virtual const char* restore_value(const char* begin,
+					    const char* end) = 0;
+
+	  virtual bool uint_assign_to(unsigned int&) const = 0;
+	  virtual bool bitcount_assign_to(unsigned int& val) const
+	       {
+		    bool ret = uint_assign_to(val);
+		    val = bitcount(val);
+		    return ret;
+	       }
+
+	  //! Set the function computing the value assigned when absent
+	  /** The function assigns the default value to its argument (a value of
+	   *  the given type); the description is shown in the help output.
+	   *  \return False if the option does not store values of that type
+	   */
+	  virtual bool set_default(const std::function<void (void*)>&,
+				   const std::type_info&,
+				   const std::string&)
+	       {
+		    return false;
+	       }
+	  //! Assign the default value if the option has not been consumed
+	  /** The default value is computed on the first call only.
+	   *  \return Whether the default value was assigned
+	   */
+	  virtual bool apply_default() { return false; }
+	  //! Description of the default value (empty if none)
+	  const std::string& default_desc() const { return default_desc_; }
+
+	  //! Add a check run on each value of the given type after parsing
+	  /** \return False if the option does not store values of that type
+	   */
+	  virtual bool add_validator(const std::function<std::string (const void*)>&,
+				     const std::type_info&)
+	       {
+		    return false;
+	       }
+	  //! Append one task per validator and value (if consumed)
+	  virtual void validation_tasks(std::vector<ValidationTask>&) const {}
+
+	  //! Prepare the target to receive n more values
+	  /** \return False if the option does not pre-size its target
+	   */
+	  virtual bool reserve_values(std::size_t) { return false; }
+
+     protected:
+	  std::string short_name_;
+	  std::string long_name_;
+	  std::string help_name_;
+	  std::string desc_;
+	  std::string default_desc_;
+	  bool consumed_;
+	  bool required_;
+     };
+
+     // ========================================================================
+
+     typedef bool (OptionValueBase::*assign_func_t)(unsigned int&) const;
+     
+     struct CountDependentOption
+     {
+	  CountDependentOption(const char* name_a,
+			       DEPENDENT_FUNCTION func_type_a = INVALID_FUNC,
+			       bool force_exact_count_a = true)
+	       : name(name_a)
+	       , func_type(func_type_a)
+	       , func(NULL)
+	       , dependent(NULL)
+	       , force_exact_count(force_exact_count_a)
+	       {
+		    switch(func_type) {
+		    case UINT_ASSIGN:
+			 func = &OptionValueBase::uint_assign_to;
+			 break;
+		    case BITCOUNT_ASSIGN:
+			 func = &OptionValueBase::bitcount_assign_to;
+			 break;
+		    default:
+			 func = NULL;
+		    }
+	       }
+	  
+	  std::string name;
+	  DEPENDENT_FUNCTION func_type;
+	  assign_func_t func;
+	  OptionValueBase* dependent;
+	  bool force_exact_count;
+     };
+     
+     inline CountDependentOption count_depends_on(const char* name)
+	  {
+	       return CountDependentOption(name, UINT_ASSIGN);
+	  }
+     inline CountDependentOption count_depends_on_bitcount(const char* name)
+	  {
+	       return CountDependentOption(name, BITCOUNT_ASSIGN);
+	  }
+     
+     // ------------------------------------------------------------------------
+
+     struct AnythingButLast {};
+     inline AnythingButLast anything_but_last()
+	  {
+	       return AnythingButLast();
+	  }
+     
+     // ------------------------------------------------------------------------
+
+     //! Callback receiving the values of a streaming positional option
+     template <typename T>
+     struct ValueCallback
+     {
+	  typedef std::function<bool (const T&)> function_type;
+
+	  explicit ValueCallback(const function_type& func_a)
+	       : func(func_a)
+	       {}
+
+	  function_type func;
+     };
+
+     //! Create a callback target for a streaming positional option
+     /** \param func Function called with each converted value, returning
+      *         false to reject the value
+      */
+     template <typename T, typename F>
+     ValueCallback<T> for_each_value(F func)
+     {
+	  return ValueCallback<T>(func);
+     }
+
+     // ------------------------------------------------------------------------
+
+     //! Function computing the default value of an option
+     template <typename T>
+     struct DefaultValue
+     {
+	  typedef std::function<T ()> function_type;
+
+	  DefaultValue(const function_type& func_a, const char* description_a)
+	       : func(func_a)
+	       , description(description_a)
+	       {}
+
+	  //! Assign the default value to value (a T)
+	  void operator()(void* value) const
+	       {
+		    *static_cast<T*>(value) = func();
+	       }
+
+	  function_type func;
+	  std::string description;
+     };
+
+     //! Create a lazily computed default value
+     /** \param func Function returning the default value (a T), only called
+      *         if the option is absent
+      *  \param description Shown in the help output (func is not called)
+      */
+     template <typename T, typename F>
+     DefaultValue<T> default_from(F func, const char* description)
+     {
+	  return DefaultValue<T>(func, description);
+     }
+
+     // ------------------------------------------------------------------------
+
+     //! Check run on converted values after parsing
+     /** For vector targets, the check is run on each element. Checks of
+      *  different values may run concurrently and must not throw.
+      */
+     template <typename T>
+     struct Validator
+     {
+	  //! Returns an error message, empty if the value is valid
+	  typedef std::function<std::string (const T&)> function_type;
+
+	  explicit Validator(const function_type& func_a)
+	       : func(func_a)
+	       {}
+
+	  //! Check value (a T)
+	  std::string operator()(const void* value) const
+	       {
+		    return func(*static_cast<const T*>(value));
+	       }
+
+	  function_type func;
+     };
+
+     //! Create a validator from a function returning an error message
+     template <typename T, typename F>
+     Validator<T> check_with(F func)
+     {
+	  return Validator<T>(func);
+     }
+
+     //! Range check of in_range()
+     template <typename T>
+     struct RangeCheck
+     {
+	  std::string operator()(const T& value) const
+	       {
+		    if (value < low || high < value) {
+			 return "not in [" + std::to_string(low) + ", "
+			      + std::to_string(high) + "]";
+		    }
+		    return std::string();
+	       }
+
+	  T low;
+	  T high;
+     };
+
+     //! Validator accepting values in [low, high] (arithmetic types)
+     template <typename T>
+     Validator<T> in_range(T low, T high)
+     {
+	  const RangeCheck<T> check = {low, high};
+	  return Validator<T>(check);
+     }
+
+     //! Validator accepting paths to existing files or directories
+     Validator<std::string> existing_path();
+     //! Validator accepting paths to readable files or directories
+     Validator<std::string> readable_path();
+     //! Validator accepting well-formed UTF-8 strings
+     /** The error gives the offset of the first invalid byte sequence.
+      */
+     Validator<std::string> valid_utf8();
+
+     // ========================================================================
+
+     //! Handling of repeated keys by map options
+     enum KEY_POLICY {
+	  LAST_WINS,		//!< The last value given for a key is kept
+	  UNIQUE_KEYS		//!< Repeating a key is an invalid value
+     };
+
+     // ========================================================================
+
+     //! Vector kept sorted and free of duplicates as values are inserted
+     /** Bound like any other container; each value is inserted at its
+      *  sorted position (a value already present is dropped).
+      */
+     template <typename T>
+     class SortedUniqueVector : public std::vector<T>
+     {};
+
+     // ------------------------------------------------------------------------
+
+     //! Header stored before each string of an InternPool
+     struct InternEntry
+     {
+	  std::size_t size;
+	  std::uint64_t hash;
+     };
+
+     //! Handle to a string stored in an InternPool
+     /** The handle is a single pointer: handles of the same pool are equal
+      *  if and only if they point to the same string. The string lives as
+      *  long as its pool.
+      */
+     class InternedString
+     {
+     public:
+	  //! Empty string (equal to any interned empty string)
+	  InternedString() : str_(NULL) {}
+
+	  const char* c_str() const { return str_ == NULL ? "" : str_; }
+	  std::size_t size() const
+	       {
+		    return str_ == NULL ? 0 : entry_()->size;
+	       }
+	  bool empty() const { return str_ == NULL; }
+	  std::string str() const { return std::string(c_str(), size()); }
+
+	  friend bool operator==(InternedString a, InternedString b)
+	       {
+		    return a.str_ == b.str_;
+	       }
+	  friend bool operator!=(InternedString a, InternedString b)
+	       {
+		    return a.str_ != b.str_;
+	       }
+	  //! Lexicographic order of the strings
+	  friend bool operator<(InternedString a, InternedString b);
+
+     private:
+	  friend class InternPool;
+	  friend struct std::hash<InternedString>;
+
+	  explicit InternedString(const char* str) : str_(str) {}
+	  const InternEntry* entry_() const
+	       {
+		    return reinterpret_cast<const InternEntry*>(str_) - 1;
+	       }
+
+	  const char* str_;
+     };
+
+     //! Storage of distinct strings
+     /** Strings are copied once into large blocks (never moved nor freed
+      *  before the pool) and found again through an open addressing hash
+      *  table of the stored strings.
+      */
+     class InternPool
+     {
+     public:
+	  InternPool();
+	  ~InternPool();
+
+	  //! Handle to the stored copy of [str, str + size)
+	  InternedString intern(const char* str, std::size_t size);
+	  InternedString intern(const std::string& str)
+	       {
+		    return intern(str.data(), str.size());
+	       }
+
+	  //! Number of distinct strings
+	  std::size_t size() const { return count_; }
+	  //! Bytes allocated for the strings
+	  std::size_t memory() const { return memory_; }
+
+     private:
+	  InternPool(const InternPool&);
+	  InternPool& operator=(const InternPool&);
+
+	  char* allocate_(std::size_t n);
+	  void grow_table_();
+
+	  std::vector<char*> blocks_;
+	  char* free_;
+	  std::size_t free_size_;
+	  std::size_t memory_;
+	  //! Stored strings by hash (NULL for empty slots)
+	  std::vector<const char*> table_;
+	  std::size_t count_;
+     };
+
+     //! Container of interned strings
+     /** Bound like any other container: each value is interned in the pool
+      *  and only its handle is stored, so repeated values take the size of
+      *  a pointer. Copies share the pool.
+      */
+     class InternedStrings
+     {
+     public:
+	  typedef InternedString value_type;
+	  typedef std::vector<InternedString>::const_iterator iterator;
+	  typedef std::vector<InternedString>::const_iterator const_iterator;
+
+	  InternedStrings() : pool_(std::make_shared<InternPool>()) {}
+	  //! Container interning its values in a shared pool
+	  explicit InternedStrings(const std::shared_ptr<InternPool>& pool)
+	       : pool_(pool)
+	       {}
+
+	  void push_back(const std::string& str)
+	       {
+		    values_.push_back(pool_->intern(str));
+	       }
+	  void push_back(InternedString str) { values_.push_back(str); }
+	  void reserve(std::size_t n) { values_.reserve(n); }
+	  void clear() { values_.clear(); }
+
+	  std::size_t size() const { return values_.size(); }
+	  bool empty() const { return values_.empty(); }
+	  InternedString operator[](std::size_t i) const { return values_[i]; }
+	  const_iterator begin() const { return values_.begin(); }
+	  const_iterator end() const { return values_.end(); }
+
+	  InternPool& pool() const { return *pool_; }
+
+     private:
+	  std::shared_ptr<InternPool> pool_;
+	  std::vector<InternedString> values_;
+     };
+
+     // ------------------------------------------------------------------------
+
+     //! Map a file in memory (read into memory where mapping is unsupported)
+     /** \param data Set to the beginning of the contents
+      *  \param size Set to the size of the file
+      *  \return Owner of the contents (NULL if the file cannot be read)
+      */
+     std::shared_ptr<const void> map_file(const std::string& path,
+					  const void*& data,
+					  std::size_t& size);
+
+     //! Read-only array of values mapped from a binary file
+     /** Bound as a single-valued option whose argument is "@file:path": the
+      *  file holds raw values of type T (little-endian) and is mapped in
+      *  memory without any conversion nor copy. Copies share the mapping.
+      */
+     template <typename T>
+     class MappedArray
+     {
+     public:
+	  typedef T value_type;
+	  typedef const T* iterator;
+	  typedef const T* const_iterator;
+
+	  MappedArray() : data_(NULL), size_(0) {}
+
+	  //! Map a file of raw values
+	  /** \return False if the file cannot be read, if its size is not a
+	   *          multiple of sizeof(T) or if the host is big-endian
+	   */
+	  bool map(const std::string& path)
+	       {
+		    const std::uint16_t one(1);
+		    const void* data(NULL);
+		    std::size_t size(0);
+		    if (*reinterpret_cast<const unsigned char*>(&one) != 1) {
+			 return false;
+		    }
+		    std::shared_ptr<const void> file(map_file(path, data, size));
+		    if (!file || size % sizeof(T) != 0) {
+			 return false;
+		    }
+		    file_ = file;
+		    data_ = static_cast<const T*>(data);
+		    size_ = size / sizeof(T);
+		    return true;
+	       }
+
+	  const T* data() const { return data_; }
+	  std::size_t size() const { return size_; }
+	  bool empty() const { return size_ == 0; }
+	  const T& operator[](std::size_t i) const { return data_[i]; }
+	  const_iterator begin() const { return data_; }
+	  const_iterator end() const { return data_ + size_; }
+
+     private:
+	  std::shared_ptr<const void> file_;
+	  const T* data_;
+	  std::size_t size_;
+     };
+
+     // ------------------------------------------------------------------------
+
+     //! Number of bytes given with an optional unit (eg. 64GiB or 1.5MB)
+     /** Units are B, kB (or KB), MB, GB and TB for powers of 1000 and KiB,
+      *  MiB, GiB and TiB for powers of 1024; values are 64-bit and must be
+      *  a whole number of bytes (no silent truncation nor overflow).
+      */
+     struct ByteSize
+     {
+	  ByteSize() : bytes(0) {}
+	  explicit ByteSize(std::uint64_t n) : bytes(n) {}
+
+	  std::uint64_t bytes;
+     };
+
+     // ------------------------------------------------------------------------
+
+     //! Whether values of type C can be bound to multi-valued options
+     /** Any type with iterators and a value_type except strings and maps
+      *  (see KEY_POLICY).
+      */
+     template <typename C>
+     class is_container
+     {
+	  template <typename U>
+	  static std::true_type test(typename U::iterator*,
+				     typename U::value_type*);
+	  template <typename U>
+	  static std::false_type test(...);
+	  template <typename U>
+	  static std::true_type is_map(typename U::mapped_type*);
+	  template <typename U>
+	  static std::false_type is_map(...);
+
+     public:
+	  static const bool value =
+	       decltype(test<C>(NULL, NULL))::value
+	       && !decltype(is_map<C>(NULL))::value
+	       && !std::is_same<C, std::string>::value;
+     };
+
+     // ========================================================================
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 T& value,
+				 const char* desc,
+				 bool required);
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* s_name,
+				 const char* l_name,
+				 const char* h_name,
+				 T& value,
+				 const char* desc,
+				 bool required);
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 T& value,
+				 T value_to_assign,
+				 const char* desc,
+				 bool required);
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* s_name,
+				 const char* l_name,
+				 const char* h_name,
+				 T& value,
+				 T value_to_assign,
+				 const char* desc,
+				 bool required);
+
+     //! Names of a sequence of (name, value) pairs
+     template <typename L>
+     std::vector<const char*> choice_names(const L& choices);
+
+     //! Helper function to ease the creating of choice options
+     /** \param choices Sequence of (name, value) pairs
+      */
+     template <typename T, typename L>
+     OptionValueBase* make_choices(const char* short_name,
+				   const char* long_name,
+				   T& value,
+				   const L& choices,
+				   const char* desc,
+				   bool required);
+
+     //! Helper function to ease the creating of choice options
+     template <typename T, typename L>
+     OptionValueBase* make_choices(const char* help_name,
+				   T& value,
+				   const L& choices,
+				   const char* desc,
+				   bool required);
+
+     //! Helper function to ease the creating of options
+     template <typename M>
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 M& value,
+				 KEY_POLICY policy,
+				 const char* desc,
+				 bool required);
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* help_name,
+				 T& value,
+				 const char* desc,
+				 bool required);
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* help_name,
+				 const ValueCallback<T>& callback,
+				 const char* desc,
+				 bool required);
+
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* short_name,
+				     const char* long_name,
+				     C& value,
+				     unsigned int count,
+				     const char* desc,
+				     bool required);
+
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* help_name,
+				     C& value,
+				     unsigned int count,
+				     const char* desc,
+				     bool required);
+
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* help_name,
+				     C& value,
+				     const CountDependentOption& dependent,
+				     const char* desc,
+				     bool required);
+     
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* help_name,
+				     C& value,
+				     const AnythingButLast& opt,
+				     const char* desc,
+				     bool required);
+
+     // ------------------------------------------------------------------------
+
+     /*
+      * Options binding values of these types (and vectors of them) are
+      * instantiated once in program_options.cpp; translation units binding
+      * only such values do not need program_options_impl.hpp.
+      */
+#define PROGRAM_OPTIONS_VALUE_TEMPLATES(EXTERN, T)			\
+     EXTERN template OptionValueBase*					\
+     make_value<T>(const char*, const char*, T&, const char*, bool);	\
+     EXTERN template OptionValueBase*					\
+     make_value<T>(const char*, const char*, const char*, T&,		\
+		   const char*, bool);					\
+     EXTERN template OptionValueBase*					\
+     make_value<T>(const char*, const char*, T&, T, const char*, bool);	\
+     EXTERN template OptionValueBase*					\
+     make_value<T>(const char*, const char*, const char*, T&, T,	\
+		   const char*, bool);					\
+     EXTERN template OptionValueBase*					\
+     make_value<T>(const char*, T&, const char*, bool);			\
+     EXTERN template OptionValueBase*					\
+     make_value<T>(const char*, const ValueCallback<T>&, const char*, bool); \
+     EXTERN template OptionValueBase*					\
+     make_container< std::vector<T> >(const char*, const char*,		\
+				      std::vector<T>&, unsigned int,	\
+				      const char*, bool);		\
+     EXTERN template OptionValueBase*					\
+     make_container< std::vector<T> >(const char*, std::vector<T>&,	\
+				      unsigned int, const char*, bool); \
+     EXTERN template OptionValueBase*					\
+     make_container< std::vector<T> >(const char*, std::vector<T>&,	\
+				      const CountDependentOption&,	\
+				      const char*, bool);		\
+     EXTERN template OptionValueBase*					\
+     make_container< std::vector<T> >(const char*, std::vector<T>&,	\
+				      const AnythingButLast&,		\
+				      const char*, bool)
+
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(extern, int);
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(extern, unsigned int);
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(extern, double);
+     PROGRAM_OPTIONS_VALUE_TEMPLATES(extern, std::string);
+
+     //! Helper function to ease the creating of switch options
+     /** Preferred over the template: the bound boolean is set to true when
+      *  the option is found and the option takes no value.
+      */
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 bool& value,
+				 const char* desc,
+				 bool required);
+     //! Helper function to ease the creating of switch options
+     OptionValueBase* make_value(const char* s_name,
+				 const char* l_name,
+				 const char* h_name,
+				 bool& value,
+				 const char* desc,
+				 bool required);
+} // namespace internal_
+
+namespace std {
+     //! Hash of the handle (strings of a pool are distinct)
+     template <>
+     struct hash<internal_::InternedString>
+     {
+	  std::size_t operator()(internal_::InternedString str) const
+	       {
+		    return std::hash<const char*>()(str.str_);
+	       }
+     };
+} // namespace std
+
+namespace internal_ {
+     struct ParseCache;
+     struct ConstraintSet;
+     struct Overlay;
+     struct ValidationPool;
+     struct ValueOps;
+
+     //! Option declared at namespace scope, next to the code using it
+     /** Registering an option only links its descriptor into a global list
+      *  whose head is constant-initialized (so that descriptors of all
+      *  translation units may be registered in any order) and allocates
+      *  nothing. The option itself is created by the managers calling
+      *  add_static_options(), when they first parse arguments (or look the
+      *  option up by name).
+      *  \code
+      *  static unsigned int jobs(1);
+      *  static StaticOption jobs_option("j", "jobs", jobs, "parallel jobs");
+      *  \endcode
+      *  \note Defined in program_options_impl.hpp
+      */
+     class StaticOption
+     {
+     public:
+	  //! Option with a single value
+	  template <typename T>
+	  StaticOption(const char* short_name,
+		       const char* long_name,
+		       T& value,
+		       const char* desc,
+		       bool required = false);
+	  //! Option taking count values per occurrence (see add_option())
+	  template <typename C>
+	  StaticOption(const char* short_name,
+		       const char* long_name,
+		       C& value,
+		       unsigned int count,
+		       const char* desc,
+		       bool required = false);
+	  //! Switch setting value to true
+	  StaticOption(const char* short_name,
+		       const char* long_name,
+		       bool& value,
+		       const char* desc,
+		       bool required = false);
+
+	  //! Registered options (most recently registered first)
+	  static const StaticOption* first() { return first_; }
+	  const StaticOption* next() const { return next_; }
+
+	  const char* short_name() const { return short_name_; }
+	  const char* long_name() const { return long_name_; }
+	  //! New option described by this object
+	  OptionValueBase* make_option() const;
+
+     private:
+	  StaticOption(const StaticOption&);
+	  StaticOption& operator=(const StaticOption&);
+
+	  void register_()
+	       {
+		    next_ = first_;
+		    first_ = this;
+	       }
+
+	  const char* short_name_;
+	  const char* long_name_;
+	  const char* desc_;
+	  void* target_;
+	  const ValueOps* ops_;
+	  //! Values per occurrence (0 for single values and switches)
+	  unsigned int count_;
+	  bool switch_;
+	  bool required_;
+	  const StaticOption* next_;
+
+	  static const StaticOption* first_;
+     };
+} // namespace internal_
+
+class ProgramOptionManager;
+
+// =============================================================================
+
+//! Base class for sources of arguments other than argv
+class ArgumentSource
+{
+public:
+     virtual ~ArgumentSource() {}
+
+     //! Read the next argument
+     /** \return False once no more arguments are available (or on error)
+      */
+     virtual bool next(std::string& arg) = 0;
+
+     //! Whether the source stopped because of an error
+     virtual bool failed() const { return false; }
+     //! Description of the error (empty if unknown)
+     virtual std::string error() const { return std::string(); }
+
+     //! Arguments longer than size bytes will be rejected by the consumer
+     /** Sources may then return a truncated argument of size + 1 bytes
+      *  instead of buffering all of it.
+      */
+     virtual void set_max_argument_size(std::size_t size) { (void) size; }
+};
+
+// -----------------------------------------------------------------------------
+
+//! Argument source reading delimited arguments from a file descriptor
+/** The file descriptor is read in fixed-size chunks, so that memory usage
+ *  does not depend on the number of arguments (only on the size of the
+ *  longest argument). Typical usage is reading the output of `find -print0`
+ *  from standard input.
+ */
+class FdArgumentSource : public ArgumentSource
+{
+public:
+     enum {DEFAULT_CHUNK_SIZE = 64 * 1024};
+
+     //! Constructor
+     /** \param fd File descriptor to read from (not closed by this class)
+      *  \param delimiter Character separating arguments ('\0' or '\n')
+      *  \param chunk_size Size of each read
+      */
+     FdArgumentSource(int fd,
+		      char delimiter = '\0',
+		      std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+     bool next(std::string& arg);
+     bool failed() const { return failed_; }
+     std::string error() const;
+     //! Stop reading after size + 1 bytes of an argument (and after it)
+     void set_max_argument_size(std::size_t size) { max_argument_size_ = size; }
+
+     //! Reject arguments that are not well-formed UTF-8
+     /** Reading stops at the first invalid argument; error() gives the
+      *  offset of the invalid bytes in the input.
+      */
+     void set_utf8_check(bool check) { utf8_check_ = check; }
+
+private:
+     //! Read the next chunk, return false on end of file or error
+     bool fill_();
+
+     int fd_;
+     char delimiter_;
+     std::vector<char> buffer_;
+     std::size_t begin_;
+     std::size_t end_;
+     //! Offset in the input of the beginning of the buffer
+     std::size_t offset_;
+     bool eof_;
+     bool failed_;
+     bool utf8_check_;
+     //! Offset in the input of the first invalid UTF-8 sequence
+     std::size_t utf8_error_;
+     std::size_t max_argument_size_;
+};
+
+// -----------------------------------------------------------------------------
+
+//! Argument source splitting a command line like a POSIX shell
+/** Words are separated by blanks (space, tab or newline); quotes and
+ *  backslashes are removed as by the shell:
+ *    - a backslash quotes the next character (backslash-newline is removed)
+ *    - '...' is taken literally
+ *    - "..." is taken literally, except for backslashes before $, `, ", a
+ *      backslash or a newline
+ *  No expansion takes place ($, `, *, ~ are ordinary characters).
+ *
+ *  Splitting is done in place, one word at a time: each word is unquoted
+ *  into the buffer and NUL-terminated, so that no copy of the command line
+ *  is made. next() then copies the word into the argument string of the
+ *  parser, as is done for each element of argv.
+ */
+class CommandLineSource : public ArgumentSource
+{
+public:
+     //! Constructor
+     /** \param command NUL-terminated command line (modified in place)
+      */
+     explicit CommandLineSource(char* command);
+
+     bool next(std::string& arg);
+     bool failed() const { return error_ != NULL; }
+     std::string error() const;
+
+     //! Split the next word in place
+     /** \return Pointer to the word, NUL-terminated in the buffer (NULL once
+      *          all words are read or on error)
+      */
+     char* next_word(std::size_t& size);
+
+private:
+     //! Next character to read
+     char* read_;
+     //! Next character to write (never after read_)
+     char* write_;
+     //! Description of the syntax error (NULL if none)
+     const char* error_;
+};
+
+// =============================================================================
+
+//! Event produced by ParseEventStream
+struct ParseEvent
+{
+     enum TYPE {
+	  OPTION_MATCHED,	//!< Option name found (flags are set at this point)
+	  VALUE_CONVERTED,	//!< Value converted for a named option
+	  POSITIONAL_VALUE,	//!< Value converted for a positional option
+	  END_OF_OPTIONS,	//!< '--' separator found
+	  PARSE_ERROR		//!< Error (see error)
+     };
+
+     enum ERROR_CODE {
+	  NONE,
+	  UNKNOWN_OPTION,	//!< Option name not registered
+	  UNEXPECTED_ARGUMENT,	//!< Argument not accepted by any positional
+	  DUPLICATE_OPTION,	//!< Single-valued option or flag repeated
+	  MISSING_VALUE,	//!< Not enough values after an option name
+	  INVALID_VALUE,	//!< Argument could not be converted
+	  WRONG_COUNT,		//!< Positional did not get the exact count
+	  MISSING_REQUIRED,	//!< Required option absent (end of parsing)
+	  INPUT_ERROR,		//!< Arguments could not be read from the source
+	  VALIDATION_FAILED,	//!< Value rejected by a validator (after parsing)
+	  CONSTRAINT_VIOLATED,	//!< Rule between options broken (after parsing)
+	  LIMIT_EXCEEDED	//!< Input beyond the ParseLimits set
+     };
+
+     TYPE type;
+     ERROR_CODE error;
+     //! Option concerned by the event (NULL if none)
+     const internal_::OptionValueBase* option;
+     //! Index of the related argument (-1 if none)
+     /** Arguments read from an ArgumentSource are numbered after argv
+      */
+     std::ptrdiff_t token;
+};
+
+// -----------------------------------------------------------------------------
+
+//! Bounds on the input of a hardened ProgramOptionManager
+/** Meant for command lines submitted by untrusted users: parsing stops at
+ *  the first argument beyond a limit with a LIMIT_EXCEEDED error, so that
+ *  the time and memory spent are linear in the size of the input accepted.
+ *  \see ProgramOptionManager::set_parse_limits()
+ */
+struct ParseLimits
+{
+     ParseLimits()
+	  : max_arguments(4096)
+	  , max_argument_size(64 * 1024)
+	  , max_total_size(1024 * 1024)
+	  , max_occurrences(256)
+	  , max_file_arguments(0)
+	  {}
+
+     //! Number of arguments (argv[0] excluded, arguments of a source included)
+     std::size_t max_arguments;
+     //! Size in bytes of a single argument
+     std::size_t max_argument_size;
+     //! Size in bytes of all the arguments
+     std::size_t max_total_size;
+     //! Occurrences of a single named option (under any of its names)
+     std::size_t max_occurrences;
+     //! Number of "@file:path" arguments
+     /** Files of values are not expanded recursively, so their nesting is
+      *  at most one level. None are accepted by default: paths given by
+      *  untrusted users should not be opened.
+      */
+     std::size_t max_file_arguments;
+};
+
+// -----------------------------------------------------------------------------
+
+//! Arguments left over by ProgramOptionManager::process_known_arguments()
+/** This is a view over the original argv array: unrecognized arguments are
+ *  moved (as pointers, without copying any string) to the end of argv, in
+ *  their original order. Since argv[argc] is NULL for the arguments of
+ *  main(), the view is NULL-terminated and can be passed to execv().
+ */
+class PassthroughArguments
+{
+public:
+     typedef char** iterator;
+
+     PassthroughArguments()
+	  : begin_(NULL)
+	  , end_(NULL)
+	  {}
+
+     //! Number of arguments
+     int argc() const { return static_cast<int>(end_ - begin_); }
+     //! Arguments (NULL-terminated if argv[argc] was NULL)
+     char** argv() const { return begin_; }
+
+     //! Arguments preceded by a program name, suitable for execv()
+     /** \param program_name Name to use as argv[0] of the child process
+      *  \note This overwrites the (already processed) argv element
+      *        preceding the first unrecognized argument
+      */
+     char** argv_with_program(char* program_name)
+	  {
+	       begin_[-1] = program_name;
+	       return begin_ - 1;
+	  }
+
+     bool empty() const { return begin_ == end_; }
+     std::size_t size() const { return end_ - begin_; }
+     char* operator[](std::size_t i) const { return begin_[i]; }
+     iterator begin() const { return begin_; }
+     iterator end() const { return end_; }
+
+private:
+     friend class ProgramOptionManager;
+
+     char** begin_;
+     char** end_;
+};
+
+// -----------------------------------------------------------------------------
+
+//! Pull parser producing parsing events one at a time
+/** Arguments are processed from left to right and only as far as the
+ *  caller pulls events, so that it is possible to react to an option as
+ *  soon as it is found (eg. stop right after --version). Named options
+ *  store their values as they are converted; positional arguments are
+ *  distributed in order to the positional options.
+ *
+ *  Once all arguments are processed, positional options are completed and
+ *  missing required options are reported, each as one event.
+ *
+ *  \note ProgramOptionManager::process_arguments() is a consumer of this
+ *        stream
+ */
+class ParseEventStream
+{
+public:
+     typedef internal_::OptionValueBase OptionValueBase;
+
+     //! Input iterator over the events of a stream
+     class iterator
+     {
+     public:
+	  typedef std::input_iterator_tag iterator_category;
+	  typedef ParseEvent value_type;
+	  typedef std::ptrdiff_t difference_type;
+	  typedef const ParseEvent* pointer;
+	  typedef const ParseEvent& reference;
+
+	  iterator() : stream_(NULL) {}
+	  explicit iterator(ParseEventStream* stream)
+	       : stream_(stream)
+	       {
+		    ++*this;
+	       }
+
+	  reference operator*() const { return event_; }
+	  pointer operator->() const { return &event_; }
+	  iterator& operator++()
+	       {
+		    if (!stream_->next(event_)) {
+			 stream_ = NULL;
+		    }
+		    return *this;
+	       }
+	  bool operator==(const iterator& rhs) const { return stream_ == rhs.stream_; }
+	  bool operator!=(const iterator& rhs) const { return stream_ != rhs.stream_; }
+
+     private:
+	  ParseEventStream* stream_;
+	  ParseEvent event_;
+     };
+
+     //! Constructor
+     /** \note Finalizes the schema of the manager (ie. adds the -h/--help
+      *        flag option)
+      */
+     ParseEventStream(ProgramOptionManager& manager, int argc, char** argv);
+     //! Constructor reading more arguments from a source once argv is exhausted
+     ParseEventStream(ProgramOptionManager& manager, int argc, char** argv,
+		      ArgumentSource& source);
+
+     //! Produce the next event
+     /** \return False once all events have been produced
+      */
+     bool next(ParseEvent& event);
+
+     //! Text of the argument related to the last event produced
+     const std::string& argument() const { return argument_; }
+
+     //! Stop processing arguments at the '--' separator
+     /** By default, arguments following '--' are all treated as positional
+      *  arguments (even if they start with '-').
+      */
+     void stop_at_separator(bool stop) { stop_at_separator_ = stop; }
+     //! Index of the '--' separator (-1 if not found yet)
+     std::ptrdiff_t separator() const { return separator_; }
+
+     iterator begin() { return iterator(this); }
+     iterator end() { return iterator(); }
+
+private:
+     enum STATE {
+	  PARSING,
+	  COMPLETING,
+	  CHECKING_REQUIRED,
+	  DONE
+     };
+
+     //! Get the next argument (splitting -xVALUE into -x VALUE)
+     bool take_(std::string& arg, std::ptrdiff_t& index);
+     //! Look at the next argument without consuming it
+     bool peek_();
+     //! Set up the limits of the manager (if any)
+     void apply_limits_();
+     //! Check a new argument against the limits (limit_error_ set if not)
+     bool check_limits_(const std::string& arg, std::ptrdiff_t index);
+     //! Count one more occurrence of a named option against the limits
+     bool check_occurrence_(const OptionValueBase* opt);
+     //! Produce the error event of the limit exceeded and stop
+     bool limit_event_(ParseEvent& event);
+     //! Give a positional argument to the current positional option
+     bool dispatch_positional_(const std::string& arg, std::ptrdiff_t index,
+			       ParseEvent& event);
+     //! Fill an event
+     bool make_event_(ParseEvent& event,
+		      ParseEvent::TYPE type,
+		      ParseEvent::ERROR_CODE error,
+		      const OptionValueBase* option,
+		      std::ptrdiff_t token);
+
+     ProgramOptionManager& manager_;
+     int argc_;
+     char** argv_;
+     ArgumentSource* source_;
+     STATE state_;
+     bool stop_at_separator_;
+     std::ptrdiff_t separator_;
+
+     //! Index of the next argument to read
+     std::ptrdiff_t argi_;
+     //! Second half of a split -xVALUE argument
+     bool has_split_;
+     std::string split_;
+     std::ptrdiff_t split_index_;
+     //! Argument read ahead by peek_()
+     bool has_lookahead_;
+     std::string lookahead_;
+     std::ptrdiff_t lookahead_index_;
+
+     //! Named option currently receiving values
+     OptionValueBase* current_;
+     std::ptrdiff_t current_index_;
+     std::string current_name_;
+
+     //! Positional option currently receiving values (or position in the
+     //! completion/required checks)
+     std::size_t position_;
+     //! Argument held back by a positional skipping the last argument
+     bool has_held_;
+     std::string held_;
+     std::ptrdiff_t held_index_;
+
+     friend class ProgramOptionManager;
+     //! Whether only overriding named options are parsed (see
+     //! ProgramOptionManager::process_overlay())
+     bool overlay_;
+
+     //! Limits of the manager (NULL if none)
+     const ParseLimits* limits_;
+     //! Size in bytes of the arguments read so far
+     std::size_t total_size_;
+     std::size_t file_arguments_;
+     //! Occurrences of each named option, sorted by option
+     std::vector< std::pair<const OptionValueBase*, std::size_t> > occurrences_;
+     //! Description of the limit exceeded (empty if none)
+     std::string limit_error_;
+     std::ptrdiff_t limit_index_;
+
+     std::string argument_;
+};
+
+// -----------------------------------------------------------------------------
+
+//! Error produced by the last call to one of the parsing functions
+struct ParseError
+{
+     ParseError()
+	  : code(ParseEvent::NONE)
+	  , token(-1)
+	  , option(-1)
+	  {}
+
+     //! Kind of error (NONE if no error occurred)
+     ParseEvent::ERROR_CODE code;
+     //! Index in argv of the offending argument (-1 if none)
+     std::ptrdiff_t token;
+     //! Id of the option involved (-1 if none)
+     /** \see ProgramOptionManager::option()
+      */
+     int option;
+};
+
+using internal_::anything_but_last;
+using internal_::count_depends_on;
+using internal_::count_depends_on_bitcount;
+using internal_::for_each_value;
+using internal_::default_from;
+using internal_::check_with;
+using internal_::in_range;
+using internal_::existing_path;
+using internal_::readable_path;
+using internal_::valid_utf8;
+using internal_::KEY_POLICY;
+using internal_::LAST_WINS;
+using internal_::UNIQUE_KEYS;
+using internal_::SortedUniqueVector;
+using internal_::InternedString;
+using internal_::InternPool;
+using internal_::InternedStrings;
+using internal_::MappedArray;
+using internal_::ByteSize;
+using internal_::StaticOption;
+
+// =============================================================================
+
+//! Class managing all program options
+class ProgramOptionManager
+{
+     //! Custom deleter functor
+     template <typename T>
+     struct Deleter
+     {
+	  void operator()(T t)
+	       {
+		    delete t;
+	       }
+     };
+     typedef internal_::OptionValueBase OptionValueBase;
+     typedef Deleter<OptionValueBase*> deleter;
+     typedef std::pair<std::string, OptionValueBase*> index_entry;
+
+     friend class ParseEventStream;
+     
+public:
+     //! Convenience typedef
+     typedef std::vector<OptionValueBase*>::iterator iterator;
+     //! Convenience typedef
+     typedef std::vector<OptionValueBase*>::const_iterator const_iterator;
+
+     //! Constructor
+     ProgramOptionManager(const char* prog_name,
+			  const char* desc);
+     
+     //! Destructor
+     ~ProgramOptionManager();
+
+     //! Method to add a flag or valued option
+     template <typename T>
+     ProgramOptionManager& add_option(const char* short_name,
+				      const char* long_name,
+				      T& value,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       opts_.push_back(internal_::make_value(short_name,
+						     long_name,
+						     value,
+						     desc,
+						     required));
+	       return *this;
+	  }
+     //! Method to add an option taking count values per occurrence
+     /** \param value Container receiving the values (see
+      *         internal_::container_ops): std::vector, std::deque, sets,
+      *         std::array, SortedUniqueVector or InternedStrings
+      *
+      *  Values are converted directly into the container; containers with a
+      *  reserve() method are pre-sized from the number of occurrences of the
+      *  option on the command line.
+      */
+     template <typename C>
+     typename std::enable_if<internal_::is_container<C>::value,
+			     ProgramOptionManager&>::type
+     add_option(const char* short_name,
+		const char* long_name,
+		C& value,
+		unsigned int count,
+		const char* desc,
+		bool required = false)
+	  {
+	       opts_.push_back(internal_::make_container(short_name,
+							 long_name,
+							 value,
+							 count,
+							 desc,
+							 required));
+	       return *this;
+	  }
+     //! Method to add a flag or valued option
+     template <typename T>
+     ProgramOptionManager& add_option(const char* short_name,
+				      const char* long_name,
+				      const char* help_name,
+				      T& value,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       opts_.push_back(internal_::make_value(short_name,
+						     long_name,
+						     help_name,
+						     value,
+						     desc,
+						     required));
+	       return *this;
+	  }
+
+     //! Method to add a flag
+     template <typename T>
+     ProgramOptionManager& add_option(const char* short_name,
+				      const char* long_name,
+				      T& value,
+				      T value_to_assign,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       opts_.push_back(internal_::make_value(short_name,
+						     long_name,
+						     value,
+						     value_to_assign,
+						     desc,
+						     required));
+	       return *this;
+	  }
+     
+     //! Method to add a flag
+     template <typename T>
+     ProgramOptionManager& add_option(const char* short_name,
+				      const char* long_name,
+				      const char* help_name,
+				      T& value,
+				      T value_to_assign,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       opts_.push_back(internal_::make_value(short_name,
+						     long_name,
+						     help_name,
+						     value,
+						     value_to_assign,
+						     desc,
+						     required));
+	       return *this;
+	  }
+
+     //! Method to add an option selecting its value by name
+     /** \param choices Names accepted on the command line and the values
+      *         they assign (eg. {{"fast", FAST}, {"safe", SAFE}})
+      *
+      *  Names are looked up through a perfect hash table built when the
+      *  option is added: one hash and one string comparison per argument,
+      *  whatever the number of choices. The choices are listed in the help
+      *  and in the error reported for any other argument.
+      *
+      *  An empty list of choices or a name given more than once is reported
+      *  and the option is not added.
+      */
+     template <typename T>
+     ProgramOptionManager& add_option(const char* short_name,
+				      const char* long_name,
+				      T& value,
+				      std::initializer_list<std::pair<const char*, T> > choices,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       if (check_choices_(long_name, internal_::choice_names(choices))) {
+		    opts_.push_back(internal_::make_choices(short_name,
+							    long_name,
+							    value,
+							    choices,
+							    desc,
+							    required));
+	       }
+	       return *this;
+	  }
+
+     //! Method to add an option selecting its value by name
+     /** Overload for choices built at runtime (eg. from a table)
+      */
+     template <typename T>
+     ProgramOptionManager& add_option(const char* short_name,
+				      const char* long_name,
+				      T& value,
+				      const std::vector<std::pair<std::string, T> >& choices,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       if (check_choices_(long_name, internal_::choice_names(choices))) {
+		    opts_.push_back(internal_::make_choices(short_name,
+							    long_name,
+							    value,
+							    choices,
+							    desc,
+							    required));
+	       }
+	       return *this;
+	  }
+
+     //! Method to add a key=value option filling a map
+     /** Each occurrence of the option takes one "key=value" argument, split
+      *  on the first '='; both sides are converted like other values.
+      *  \param value Map-like container (eg. std::map or std::unordered_map)
+      *  \param policy Handling of repeated keys
+      *
+      *  Containers with a reserve() method are pre-sized from the number of
+      *  occurrences of the option on the command line.
+      */
+     template <typename M>
+     ProgramOptionManager& add_option(const char* short_name,
+				      const char* long_name,
+				      M& value,
+				      KEY_POLICY policy,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       opts_.push_back(internal_::make_value(short_name,
+						     long_name,
+						     value,
+						     policy,
+						     desc,
+						     required));
+	       return *this;
+	  }
+
+     //! Method to add a positional option with single value
+     template <typename T>
+     ProgramOptionManager& add_option(const char* help_name,
+				      T& value,
+				      const char* desc,
+				      bool required = true)
+	  {
+	       positionals_.push_back(internal_::make_value(help_name,
+							    value,
+							    desc,
+							    required));
+	       return *this;
+	  }
+
+     //! Method to add a positional option selecting its value by name
+     /** \see add_option(const char*, const char*, T&, std::initializer_list<std::pair<const char*, T> >, const char*, bool)
+      */
+     template <typename T>
+     ProgramOptionManager& add_option(const char* help_name,
+				      T& value,
+				      std::initializer_list<std::pair<const char*, T> > choices,
+				      const char* desc,
+				      bool required = true)
+	  {
+	       if (check_choices_(help_name, internal_::choice_names(choices))) {
+		    positionals_.push_back(internal_::make_choices(help_name,
+								   value,
+								   choices,
+								   desc,
+								   required));
+	       }
+	       return *this;
+	  }
+
+     //! Method to add a positional option selecting its value by name
+     /** Overload for choices built at runtime (eg. from a table)
+      */
+     template <typename T>
+     ProgramOptionManager& add_option(const char* help_name,
+				      T& value,
+				      const std::vector<std::pair<std::string, T> >& choices,
+				      const char* desc,
+				      bool required = true)
+	  {
+	       if (check_choices_(help_name, internal_::choice_names(choices))) {
+		    positionals_.push_back(internal_::make_choices(help_name,
+								   value,
+								   choices,
+								   desc,
+								   required));
+	       }
+	       return *this;
+	  }
+
+     //! Method to add a positional option with multiple values
+     /** The container is reserved for the count values before the first one
+      *  is inserted.
+      */
+     template <typename C>
+     typename std::enable_if<internal_::is_container<C>::value,
+			     ProgramOptionManager&>::type
+     add_option(const char* help_name,
+		C& value,
+		unsigned int count,
+		const char* desc,
+		bool required = true)
+	  {
+	       positionals_.push_back(internal_::make_container(help_name,
+								value,
+								count,
+								desc,
+								required));
+	       return *this;
+	  }
+
+     //! Method to add a streaming positional option
+     /** Each value is converted and handed to the callback instead of being
+      *  stored (see for_each_value())
+      */
+     template <typename T>
+     ProgramOptionManager& add_option(const char* help_name,
+				      const internal_::ValueCallback<T>& callback,
+				      const char* desc,
+				      bool required = false)
+	  {
+	       positionals_.push_back(internal_::make_value(help_name,
+							    callback,
+							    desc,
+							    required));
+	       return *this;
+	  }
+
+     //! Method to add a positional option with multiple values (skipping the last existing argument)
+     template <typename C>
+     typename std::enable_if<internal_::is_container<C>::value,
+			     ProgramOptionManager&>::type
+     add_option(const char* help_name,
+		C& value,
+		const internal_::AnythingButLast& opt,
+		const char* desc,
+		bool required = true)
+	  {
+	       positionals_.push_back(internal_::make_container(help_name,
+								value,
+								opt,
+								desc,
+								required));
+	       return *this;
+	  }
+
+     //! Method to add a positional option with multiple values
+     /** This overload makes use of a dependent option to set the maximum number
+      *  of values 
+      */
+     template <typename C>
+     typename std::enable_if<internal_::is_container<C>::value,
+			     ProgramOptionManager&>::type
+     add_option(const char* help_name,
+		C& value,
+		internal_::CountDependentOption opt,
+		const char* desc,
+		bool required = true)
+	  {
+	       opt.dependent = NULL; // just to be sure...
+	       
+	       for (unsigned int i(0);
+		    opt.dependent == NULL && i < opts_.size();
+		    ++i) {
+		    if (opt.name == opts_[i]->short_name()
+			 || opt.name == opts_[i]->long_name()) {
+			 opt.dependent = opts_[i];
+		    }
+	       }
+	       for (unsigned int i(0);
+		    opt.dependent == NULL && i < positionals_.size();
+		    ++i) {
+		    if (opt.name == positionals_[i]->help_name()) {
+			 opt.dependent = positionals_[i];
+		    }
+	       }
+
+	       if (opt.dependent == NULL) {
+		    report_("dependent option does not exist!");
+	       }
+	       else {
+		    positionals_.push_back(internal_::make_container(help_name,
+								     value,
+								     opt,
+								     desc,
+								     required));
+	       }
+	       return *this;
+	  }
+
+     //! Set a default value for an option, computed only if it is absent
+     /** \param name Short or long name of the option (help name for
+      *         positional options)
+      *  \param value Default value (see default_from())
+      *
+      *  The default value is computed once, after the first successful parse
+      *  (or snapshot restore) where the option is absent, and assigned again
+      *  after the following ones. The option is not marked as consumed.
+      *  \note Count dependent options do not see default values.
+      */
+     template <typename T>
+     ProgramOptionManager& set_default(const char* name,
+				       const internal_::DefaultValue<T>& value)
+	  {
+	       set_default_(name, value, typeid(T), value.description);
+	       return *this;
+	  }
+
+     //! Add a check of the values of an option
+     /** \param name Short or long name of the option (help name for
+      *         positional options)
+      *  \param check Validator of the values (see check_with()), run on each
+      *         element of vector targets
+      *
+      *  Validators run after a successful parse (or snapshot restore) on the
+      *  values of the options that were present. Checks of all values run
+      *  concurrently (see set_validation_threads()); errors are reported in
+      *  option, validator and element order.
+      */
+     template <typename T>
+     ProgramOptionManager& add_validator(const char* name,
+					 const internal_::Validator<T>& check)
+	  {
+	       add_validator_(name, check, typeid(T));
+	       return *this;
+	  }
+
+     //! Add the options registered by StaticOption objects
+     /** The options are created lazily, on the first parse (or when one of
+      *  them is looked up by name, eg. by set_default()). Static options
+      *  whose short or long name is already used are ignored.
+      */
+     ProgramOptionManager& add_static_options();
+
+     //! Enforce limits on the input of the parsing functions
+     /** Parsing fails with a LIMIT_EXCEEDED error as soon as an argument
+      *  goes beyond one of the limits (see ParseLimits).
+      *  \note Calls served from the parse cache are checked against the
+      *        limits in force when their command line was first parsed
+      */
+     void set_parse_limits(const ParseLimits& limits);
+     //! Remove the limits set by set_parse_limits()
+     void clear_parse_limits();
+
+     //! Set the maximum number of threads running validators
+     /** \param n_threads Number of threads (0 to use all cores, 1 to run
+      *         validators on the calling thread only)
+      */
+     void set_validation_threads(unsigned int n_threads);
+
+     /*
+      * Constraints between options, checked after a successful parse (or
+      * snapshot restore) against the set of options present. Options are
+      * designated by their short or long name (help name for positional
+      * options); options with a default value are not considered present
+      * unless they appear on the command line.
+      */
+
+     //! Allow at most one of the options to be present
+     ProgramOptionManager& add_exclusive_group(std::initializer_list<const char*> names);
+     //! Require at least one of the options to be present
+     ProgramOptionManager& add_required_group(std::initializer_list<const char*> names);
+     //! Require all the options in names whenever option name is present
+     ProgramOptionManager& add_requirement(const char* name,
+					   std::initializer_list<const char*> names);
+     //! Forbid all the options in names whenever option name is present
+     ProgramOptionManager& add_conflict(const char* name,
+					std::initializer_list<const char*> names);
+
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+     //! Set the stream receiving error messages (std::cerr by default)
+     void set_error_stream(std::ostream& err);
+     //! Set the stream receiving the usage and help (std::cout by default)
+     void set_output_stream(std::ostream& out);
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+     //! Reset the parsing state of all options (bound values are untouched)
+     /** Call this before parsing another command line with the same manager
+      */
+     void reset();
+
+     //! Usage line
+     std::string usage_text() const;
+     //! Usage line and some more detailed help messages
+     std::string help_text() const;
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+     //! Print usage line (see set_output_stream())
+     void usage();
+     //! Print usage line and some more detailed help messages (see set_output_stream())
+     void print_help();
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+     //! Error produced by the last parsing function called
+     /** The code is NONE if the last call succeeded or if the help was
+      *  requested.
+      */
+     const ParseError& last_error() const { return error_; }
+     //! Option from its id (NULL if there is no such option)
+     /** Ids are given by the last_error() function; they are stable once
+      *  the options are finalized (ie. after the first parsing).
+      */
+     const internal_::OptionValueBase* option(int id) const;
+
+     //! Method to call to process the program arguments
+     /** \return 0 if the program needs to close normally right after this call, 
+      *          >0 if everything is ok and <0 if an error occurred
+      *  \note This method will automaticall add a -h/--help flag option
+      */
+     int process_arguments(int argc, char** argv);
+     //! Method to call to process the program arguments followed by more
+     //! arguments read from a source
+     /** \note Same return values as process_arguments(int, char**); the
+      *        parse cache is not used for such calls
+      *  \note Only the options in argv are counted to pre-size containers:
+      *        arguments read from the source are inserted without it
+      */
+     int process_arguments(int argc, char** argv, ArgumentSource& source);
+
+     //! Process the arguments that are recognized and leave the others
+     /** Unknown options, arguments not accepted by any positional option and
+      *  everything after a '--' separator are not considered errors; they are
+      *  returned in order as a view over argv (see PassthroughArguments).
+      *  \param argc Number of arguments
+      *  \param argv Arguments (reordered in place)
+      *  \param unknown Receives the unrecognized arguments
+      *  \return Same as process_arguments(int, char**)
+      */
+     int process_known_arguments(int argc, char** argv,
+				 PassthroughArguments& unknown);
+
+     //! Process the arguments of a whole command line
+     /** The command line is split like a POSIX shell would (see
+      *  CommandLineSource); its first word is the program name.
+      *  \param command NUL-terminated command line, split in place
+      *  \return Same as process_arguments(int, char**); quoting errors
+      *          are INPUT_ERROR errors
+      *  \note Words are read one at a time, so containers are not pre-sized
+      *        (see process_arguments(int, char**, ArgumentSource&))
+      */
+     int process_command_line(char* command);
+     //! Process the arguments of a whole command line (copied once)
+     int process_command_line(const std::string& command);
+
+     /*
+      * Overlays: a few overriding arguments applied on top of the values of
+      * a base command line (eg. per-request options of a server started
+      * with a large configuration).
+      */
+
+     //! Use the current values as the base of overlays
+     /** Call this after a successful parse (or snapshot restore) of the
+      *  base command line, and again after parsing another base. The
+      *  values of an active overlay become part of the base.
+      */
+     void set_overlay_base();
+     //! Apply overriding arguments on top of the base values
+     /** Only named options may be given; each one replaces its base value
+      *  (all of them for multi-valued options). The base value of an
+      *  option is copied when it is first overridden and assigned back by
+      *  the next process_overlay() or clear_overlay() call, so that the
+      *  cost only depends on the overriding arguments. The constraints
+      *  involving the overridden options and their validators are checked
+      *  again; required options are already satisfied by the base.
+      *  \return Same as process_arguments(); on error, the base values are
+      *          restored
+      *  \note Callbacks of overridden options are called again (and are
+      *        not undone when the base value is restored)
+      */
+     int process_overlay(int argc, char** argv);
+     //! Restore the base values overridden by the last process_overlay()
+     void clear_overlay();
+
+     //! Enable memoization of successful process_arguments() calls
+     /** Command lines are fingerprinted (and verified byte-for-byte); a
+      *  repeated command line replays the previously converted values into
+      *  the bound targets instead of being parsed again. Before each call,
+      *  bound targets are reset to the values they had when the cache was
+      *  enabled.
+      *  \param max_entries Maximum number of cached command lines (least
+      *         recently used entries are evicted first), 0 disables the cache
+      *  \return False if some bound value cannot be serialized (see
+      *          save_snapshot())
+      *  \note Finalizes the schema (ie. adds the -h/--help flag option)
+      */
+     bool enable_parse_cache(std::size_t max_entries);
+     //! Number of process_arguments() calls served from the parse cache
+     std::size_t parse_cache_hits() const;
+     //! Number of process_arguments() calls not served from the parse cache
+     std::size_t parse_cache_misses() const;
+     
+     //! Hash identifying the option schema (names, kinds and value types)
+     /** \note Finalizes the schema (ie. adds the -h/--help flag option)
+      */
+     std::uint64_t schema_hash();
+
+     //! Serialize the values of all consumed options into a binary snapshot
+     /** \param buffer Buffer receiving the snapshot (overwritten)
+      *  \return False if some consumed value cannot be serialized
+      *  \note Meant to be called after a successful process_arguments()
+      */
+     bool save_snapshot(std::vector<char>& buffer);
+     //! Serialize the values of all consumed options into a binary file
+     bool save_snapshot(const char* filename);
+
+     //! Restore option values from a binary snapshot instead of parsing
+     /** \return >0 if everything is ok and <0 if an error occurred (invalid
+      *          data or mismatching schema hash)
+      *  \note No tokenization or conversion takes place, the cost is
+      *        proportional to the number of values stored in the snapshot
+      */
+     int restore_snapshot(const char* data, std::size_t size);
+     //! Restore option values from a (memory-mapped) binary snapshot file
+     int restore_snapshot(const char* filename);
+
+private:
+     //! Add the -h/--help flag, sort and index options (only done once)
+     void finalize_();
+     //! Find a named option from its name on the command line (-s or --long)
+     OptionValueBase* find_option_(const std::string& arg) const;
+     //! Actual parsing of the program arguments
+     /** \param stream Stream of events to consume
+      *  \param known If not NULL, flags of each argv element (bit 0:
+      *         recognized, bit 1: not recognized) instead of reporting
+      *         unrecognized arguments as errors
+      */
+     int parse_(ParseEventStream& stream, std::vector<char>* known = NULL);
+     //! Restore snapshot records (header already validated)
+     int restore_records_(const char* data, std::size_t size);
+     //! Option at a given snapshot index (positionals first)
+     OptionValueBase* option_at_(std::size_t idx) const;
+     //! Snapshot index of an option (-1 if NULL)
+     int option_id_(const OptionValueBase* opt) const;
+     //! Option with a given short, long or (positional) help name
+     OptionValueBase* option_named_(const std::string& name);
+     //! Create the static options (see add_static_options())
+     void add_static_options_();
+     void set_default_(const char* name,
+		       const std::function<void (void*)>& fill,
+		       const std::type_info& type,
+		       const std::string& description);
+     void apply_defaults_();
+     void add_validator_(const char* name,
+			 const std::function<std::string (const void*)>& check,
+			 const std::type_info& type);
+     //! Run the validators of the options that were present
+     /** \return 1 if all values are valid, -1 otherwise
+      */
+     int validate_();
+     void add_constraint_(int kind,
+			  const char* name,
+			  std::initializer_list<const char*> names);
+     //! Check that names is a non-empty list of distinct choices
+     bool check_choices_(const char* name,
+			 const std::vector<const char*>& names) const;
+     //! Check the constraints against the options present
+     /** \return 1 if no constraint is broken, -1 otherwise
+      */
+     int check_constraints_();
+     //! Check one constraint rule (seen bits up to date)
+     /** \return retval if the rule holds, -1 otherwise
+      */
+     int check_rule_(std::size_t rule, int retval);
+     //! Run validation tasks and report the errors
+     /** \return 1 if all values are valid, -1 otherwise
+      */
+     int run_validators_(std::vector<internal_::ValidationTask>& tasks);
+     //! Copy the base value of an option before it is overridden
+     void override_(OptionValueBase* opt);
+     //! Check the constraints and validators of the overridden options
+     int check_overlay_();
+     //! Pre-size the targets of options counting their occurrences in argv
+     void presize_(int argc, char** argv);
+     //! Record the error of the last parsing function call
+     int fail_(ParseEvent::ERROR_CODE code,
+	       std::ptrdiff_t token,
+	       const OptionValueBase* opt);
+     //! Report an error message (prefixed with "ERROR: ")
+     void report_(const std::string& message) const;
+
+     std::string prog_name_;
+     std::string desc_;
+     std::vector<OptionValueBase*> opts_;
+     std::vector<OptionValueBase*> positionals_;
+     //! Named options sorted by -short and --long names
+     std::vector<index_entry> index_;
+     //! Named options pre-sizing their targets (see reserve_values())
+     std::vector<OptionValueBase*> presized_;
+     bool help_;
+     bool finalized_;
+     //! Whether static options are to be added (see add_static_options())
+     bool static_options_;
+     internal_::ParseCache* cache_;
+     internal_::ConstraintSet* constraints_;
+     internal_::Overlay* overlay_;
+     //! Limits on the input (only if limited_ is set)
+     ParseLimits limits_;
+     bool limited_;
+     unsigned int validation_threads_;
+     //! Threads running the validators (created on first use)
+     internal_::ValidationPool* validation_pool_;
+     ParseError error_;
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+     std::ostream* err_;
+     std::ostream* out_;
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+};
+
+#endif //PROGRAM_OPTIONS_DECL_HPP_INCLUDED
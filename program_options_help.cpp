@@ -0,0 +1,85 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+/*
+ * Help rendering is kept apart from the parsing code: programs that never
+ * call the functions below do not link this translation unit.
+ */
+
+#include "program_options.hpp"
+
+using internal_::OptionValueBase;
+
+// =============================================================================
+
+namespace {
+     void append_help_line(std::string& out, const OptionValueBase* opt)
+     {
+	  const std::size_t pad(OptionValueBase::HELP_PAD);
+
+	  std::string entry(opt->help_entry());
+	  if (entry.size() < pad) {
+	       entry.resize(pad, ' ');
+	  }
+	  out += entry + opt->desc();
+	  if (!opt->default_desc().empty()) {
+	       out += " (default: " + opt->default_desc() + ")";
+	  }
+	  out += "\n";
+
+	  const std::string note(opt->help_note());
+	  if (!note.empty()) {
+	       out += std::string(pad, ' ') + note + "\n";
+	  }
+     }
+}
+
+// =============================================================================
+
+std::string ProgramOptionManager::usage_text() const
+{
+     std::string ret("usage: " + prog_name_);
+     for (const_iterator it(positionals_.begin()) ; it < positionals_.end() ; ++it) {
+	  ret += " " + (*it)->help_name();
+     }
+     for (const_iterator it(opts_.begin()) ; it < opts_.end() ; ++it) {
+	  ret += " " + (*it)->usage_name();
+     }
+     return ret + "\n";
+}
+
+std::string ProgramOptionManager::help_text() const
+{
+     std::string ret(usage_text());
+     if (!desc_.empty()) {
+	  ret += "\n" + desc_ + "\n";
+     }
+     ret += "\nList of options:\n";
+     for (const_iterator it(positionals_.begin()) ; it < positionals_.end() ; ++it) {
+	  append_help_line(ret, *it);
+     }
+     for (const_iterator it(opts_.begin()) ; it < opts_.end() ; ++it) {
+	  append_help_line(ret, *it);
+     }
+     return ret + "\n";
+}
+
+// -----------------------------------------------------------------------------
+
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+void ProgramOptionManager::usage()
+{
+     *out_ << usage_text() << std::flush;
+}
+
+void ProgramOptionManager::print_help()
+{
+     *out_ << help_text() << std::flush;
+}
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
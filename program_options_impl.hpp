@@ -0,0 +1,1411 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+#ifndef PROGRAM_OPTIONS_IMPL_HPP_INCLUDED
+#define PROGRAM_OPTIONS_IMPL_HPP_INCLUDED
+
+//! Definition of the option templates (see program_options_decl.hpp)
+
+#include "program_options_decl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#ifdef PROGRAM_OPTIONS_NO_IOSTREAM
+#  include <cerrno>
+#  include <cstdlib>
+#  include <limits>
+#else
+#  include <sstream>
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#  if __has_include(<filesystem>)
+#    include <filesystem>
+#    define PROGRAM_OPTIONS_HAS_FILESYSTEM
+#  endif
+#endif
+
+namespace internal_ {
+     // Inspired from Boost::TypeTraits
+     template <bool val>
+     struct integral_constant
+     {
+	  typedef bool value_type;
+	  typedef integral_constant<val> type;
+	  static const bool value = val;
+	  operator bool()const { return val; }
+     };
+
+     template <bool val>
+     bool const integral_constant<val>::value;
+
+     typedef integral_constant<true> true_type;
+     typedef integral_constant<false> false_type;
+
+     template <typename T> struct is_numeric : public false_type {};
+
+     template <> struct is_numeric<short int> : public true_type {};
+     template <> struct is_numeric<int> : public true_type {};
+     template <> struct is_numeric<long int> : public true_type {};
+     template <> struct is_numeric<unsigned short int> : public true_type {};
+     template <> struct is_numeric<unsigned int> : public true_type {};
+     template <> struct is_numeric<unsigned long int> : public true_type {};
+     template <> struct is_numeric<float> : public true_type {};
+     template <> struct is_numeric<double> : public true_type {};
+     template <> struct is_numeric<long double> : public true_type {};
+     template <> struct is_numeric<unsigned long long> : public true_type {};
+     template <> struct is_numeric<ByteSize> : public true_type {};
+     template <typename R, typename P>
+     struct is_numeric< std::chrono::duration<R, P> > : public true_type {};
+
+     
+     template <bool is_num>
+     struct do_assign
+     {
+	  template <typename U, typename T>
+	  static bool apply(U&, const T&) { return false; }
+     };
+     template <>
+     struct do_assign<true>
+     {
+	  template <typename U, typename T>
+	  static bool apply(U& u, const T& t) { u = t; return true; }
+     };
+
+
+     template <typename T>
+     struct traits
+     {
+	  template <typename U>
+	  static bool assign_to(U&u, const T& t)
+	       {
+		    return do_assign<is_numeric<T>::value
+				     && is_numeric<U>::value>::apply(u, t); 
+	       }
+     };
+
+     //! Assign a 64-bit quantity to a number (false if out of range)
+     template <typename U>
+     bool assign_checked(U& u, std::uint64_t value)
+     {
+	  if (!is_numeric<U>::value
+	      || value > static_cast<std::uint64_t>(std::numeric_limits<U>::max())) {
+	       return false;
+	  }
+	  u = static_cast<U>(value);
+	  return true;
+     }
+
+     template <>
+     struct traits<ByteSize>
+     {
+	  template <typename U>
+	  static bool assign_to(U& u, const ByteSize& t)
+	       {
+		    return assign_checked(u, t.bytes);
+	       }
+     };
+
+     //! Durations assign their number of ticks
+     template <typename R, typename P>
+     struct traits< std::chrono::duration<R, P> >
+     {
+	  template <typename U>
+	  static bool assign_to(U& u, const std::chrono::duration<R, P>& t)
+	       {
+		    return t.count() >= 0
+			 && assign_checked(u, static_cast<std::uint64_t>(t.count()));
+	       }
+     };
+
+     //! Units accepted by values of type T (shown in help, NULL if none)
+     template <typename T>
+     struct value_units
+     {
+	  static constexpr const char* value = NULL;
+     };
+     template <>
+     struct value_units<ByteSize>
+     {
+	  static constexpr const char* value =
+	       "B, kB, MB, GB, TB, KiB, MiB, GiB, TiB";
+     };
+     template <typename R, typename P>
+     struct value_units< std::chrono::duration<R, P> >
+     {
+	  static constexpr const char* value = "ns, us, ms, s, m, h";
+     };
+
+     // ========================================================================
+
+     //! Binary encoding of bound values (used by the snapshot functions)
+     /** Trivially copyable types are stored as raw bytes, strings and
+      *  vectors as a 64-bit count followed by their elements. Any other type
+      *  cannot be serialized.
+      */
+     template <typename T, bool is_trivial = std::is_trivially_copyable<T>::value>
+     struct binary_codec
+     {
+	  static bool write(std::vector<char>&, const T&) { return false; }
+	  static const char* read(const char*, const char*, T&) { return NULL; }
+     };
+
+     template <typename T>
+     struct binary_codec<T, true>
+     {
+	  static bool write(std::vector<char>& out, const T& t)
+	       {
+		    const char* p(reinterpret_cast<const char*>(&t));
+		    out.insert(out.end(), p, p + sizeof(T));
+		    return true;
+	       }
+	  static const char* read(const char* begin, const char* end, T& t)
+	       {
+		    if (static_cast<std::size_t>(end - begin) < sizeof(T)) {
+			 return NULL;
+		    }
+		    std::memcpy(&t, begin, sizeof(T));
+		    return begin + sizeof(T);
+	       }
+     };
+
+     template <>
+     struct binary_codec<std::string, false>
+     {
+	  static bool write(std::vector<char>& out, const std::string& t)
+	       {
+		    binary_codec<std::uint64_t>::write(out, t.size());
+		    out.insert(out.end(), t.begin(), t.end());
+		    return true;
+	       }
+	  static const char* read(const char* begin, const char* end,
+				  std::string& t)
+	       {
+		    std::uint64_t size(0);
+		    begin = binary_codec<std::uint64_t>::read(begin, end, size);
+		    if (begin == NULL
+			|| static_cast<std::uint64_t>(end - begin) < size) {
+			 return NULL;
+		    }
+		    t.assign(begin, size);
+		    return begin + size;
+	       }
+     };
+
+     template <typename T>
+     struct binary_codec<std::vector<T>, false>
+     {
+	  //! Elements that can be copied in bulk
+	  typedef integral_constant<std::is_trivially_copyable<T>::value
+				    && !std::is_same<T, bool>::value> is_bulk;
+
+	  static bool write(std::vector<char>& out, const std::vector<T>& t)
+	       {
+		    binary_codec<std::uint64_t>::write(out, t.size());
+		    return write_elements(out, t, is_bulk());
+	       }
+	  static const char* read(const char* begin, const char* end,
+				  std::vector<T>& t)
+	       {
+		    std::uint64_t size(0);
+		    begin = binary_codec<std::uint64_t>::read(begin, end, size);
+		    if (begin == NULL) {
+			 return NULL;
+		    }
+		    return read_elements(begin, end, size, t, is_bulk());
+	       }
+
+     private:
+	  static bool write_elements(std::vector<char>& out,
+				     const std::vector<T>& t,
+				     true_type)
+	       {
+		    if (!t.empty()) {
+			 const char* p(reinterpret_cast<const char*>(&t[0]));
+			 out.insert(out.end(), p, p + t.size() * sizeof(T));
+		    }
+		    return true;
+	       }
+	  static bool write_elements(std::vector<char>& out,
+				     const std::vector<T>& t,
+				     false_type)
+	       {
+		    for (std::size_t i(0); i < t.size(); ++i) {
+			 if (!binary_codec<T>::write(out, t[i])) {
+			      return false;
+			 }
+		    }
+		    return true;
+	       }
+	  static const char* read_elements(const char* begin,
+					   const char* end,
+					   std::uint64_t size,
+					   std::vector<T>& t,
+					   true_type)
+	       {
+		    if (static_cast<std::uint64_t>(end - begin) / sizeof(T) < size) {
+			 return NULL;
+		    }
+		    t.resize(size);
+		    if (size > 0) {
+			 std::memcpy(&t[0], begin, size * sizeof(T));
+		    }
+		    return begin + size * sizeof(T);
+	       }
+	  static const char* read_elements(const char* begin,
+					   const char* end,
+					   std::uint64_t size,
+					   std::vector<T>& t,
+					   false_type)
+	       {
+		    t.clear();
+		    t.reserve(std::min<std::uint64_t>(size, end - begin));
+		    for (; begin != NULL && size > 0; --size) {
+			 T tmp;
+			 begin = binary_codec<T>::read(begin, end, tmp);
+			 t.push_back(tmp);
+		    }
+		    return begin;
+	       }
+     };
+
+     // ========================================================================
+
+#ifndef PROGRAM_OPTIONS_NO_IOSTREAM
+     //! Convert an argument into a value
+     /** \return False if the argument could not be converted
+      */
+     template <typename T>
+     bool convert(const std::string& arg, T& value)
+     {
+	  std::istringstream ssin(arg);
+	  ssin >> value;
+	  /* 
+	   * not being able to fully consume an argument is considered an
+	   * error (could be failed conversion)
+	   */
+	  return ssin.good() || ssin.eof();
+     }
+#else
+     enum CONVERSION_KIND {
+	  SIGNED_CONVERSION,
+	  UNSIGNED_CONVERSION,
+	  FLOATING_CONVERSION,
+	  CHAR_CONVERSION,
+	  NO_CONVERSION
+     };
+
+     template <typename T>
+     struct conversion_kind
+     {
+	  static const CONVERSION_KIND value =
+	       (std::is_same<T, char>::value
+		|| std::is_same<T, signed char>::value
+		|| std::is_same<T, unsigned char>::value) ? CHAR_CONVERSION
+	       : std::is_floating_point<T>::value ? FLOATING_CONVERSION
+	       : std::is_signed<T>::value ? SIGNED_CONVERSION
+	       : std::is_integral<T>::value ? UNSIGNED_CONVERSION
+	       : NO_CONVERSION;
+     };
+
+     //! Conversion of an argument using the strto* functions
+     /** The whole argument must be consumed and the value must be in range.
+      */
+     template <typename T, CONVERSION_KIND kind = conversion_kind<T>::value>
+     struct string_converter
+     {
+	  static_assert(kind != NO_CONVERSION,
+			"without iostreams, only arithmetic types and strings "
+			"can be converted (overload convert() for other types)");
+     };
+
+     template <typename T>
+     struct string_converter<T, SIGNED_CONVERSION>
+     {
+	  static bool apply(const char* arg, T& value)
+	       {
+		    char* end(NULL);
+		    errno = 0;
+		    const long long tmp(std::strtoll(arg, &end, 10));
+		    if (end == arg || *end != '\0' || errno == ERANGE
+			|| tmp < std::numeric_limits<T>::min()
+			|| tmp > std::numeric_limits<T>::max()) {
+			 return false;
+		    }
+		    value = static_cast<T>(tmp);
+		    return true;
+	       }
+     };
+
+     template <typename T>
+     struct string_converter<T, UNSIGNED_CONVERSION>
+     {
+	  static bool apply(const char* arg, T& value)
+	       {
+		    char* end(NULL);
+		    errno = 0;
+		    const unsigned long long tmp(std::strtoull(arg, &end, 10));
+		    if (end == arg || *end != '\0' || errno == ERANGE
+			|| tmp > std::numeric_limits<T>::max()) {
+			 return false;
+		    }
+		    value = static_cast<T>(tmp);
+		    return true;
+	       }
+     };
+
+     template <typename T>
+     struct string_converter<T, FLOATING_CONVERSION>
+     {
+	  static bool apply(const char* arg, T& value)
+	       {
+		    char* end(NULL);
+		    errno = 0;
+		    const long double tmp(std::strtold(arg, &end));
+		    if (end == arg || *end != '\0' || errno == ERANGE) {
+			 return false;
+		    }
+		    value = static_cast<T>(tmp);
+		    return true;
+	       }
+     };
+
+     template <typename T>
+     struct string_converter<T, CHAR_CONVERSION>
+     {
+	  static bool apply(const char* arg, T& value)
+	       {
+		    if (arg[0] == '\0' || arg[1] != '\0') {
+			 return false;
+		    }
+		    value = static_cast<T>(arg[0]);
+		    return true;
+	       }
+     };
+
+     //! Convert an argument into a value
+     /** \return False if the argument could not be converted
+      */
+     template <typename T>
+     bool convert(const std::string& arg, T& value)
+     {
+	  return string_converter<T>::apply(arg.c_str(), value);
+     }
+#endif /* PROGRAM_OPTIONS_NO_IOSTREAM */
+
+     //! Strings take the whole argument, whitespace included
+     /** Assigned directly: no round trip through a stream (which would also
+      *  stop at the first whitespace).
+      */
+     inline bool convert(const std::string& arg, std::string& value)
+     {
+	  value = arg;
+	  return true;
+     }
+
+#ifdef PROGRAM_OPTIONS_HAS_FILESYSTEM
+     //! Paths take the whole argument, whitespace included
+     inline bool convert(const std::string& arg, std::filesystem::path& value)
+     {
+	  value = arg;
+	  return true;
+     }
+#endif /* PROGRAM_OPTIONS_HAS_FILESYSTEM */
+
+     //! Parse a size with an optional unit (see ByteSize)
+     bool convert(const std::string& arg, ByteSize& value);
+
+     //! Parse a duration into nanoseconds
+     /** \param unit_ns Nanoseconds per unit for values without a unit
+      *  \return False if the duration is invalid, is not a whole number of
+      *          nanoseconds or does not fit in 64 bits
+      */
+     bool parse_duration(const std::string& arg,
+			 std::uint64_t unit_ns,
+			 std::uint64_t& ns);
+
+     //! Parse a duration with an optional unit (ns, us, ms, s, m or h)
+     /** Values without a unit are counted in ticks of the target. With an
+      *  integral representation, the value must be a whole number of ticks
+      *  that fits in the target; floating-point ones take any fraction.
+      */
+     template <typename R, typename P>
+     bool convert(const std::string& arg, std::chrono::duration<R, P>& value)
+     {
+	  static_assert(1000000000 * P::num % P::den == 0,
+			"durations must be counted in whole nanoseconds");
+	  const std::uint64_t tick_ns(1000000000 * P::num / P::den);
+	  std::uint64_t ns(0);
+	  if (!parse_duration(arg, tick_ns, ns)) {
+	       return false;
+	  }
+	  if (!std::numeric_limits<R>::is_integer) {
+	       value = std::chrono::duration<R, P>(static_cast<R>(ns) / tick_ns);
+	       return true;
+	  }
+	  const std::uint64_t ticks(ns / tick_ns);
+	  if (ns % tick_ns != 0
+	      || ticks > static_cast<std::uint64_t>(std::numeric_limits<R>::max())) {
+	       return false;
+	  }
+	  value = std::chrono::duration<R, P>(static_cast<R>(ticks));
+	  return true;
+     }
+
+     //! Whether an argument names a file of values ("@file:path")
+     inline bool is_file_arg(const std::string& arg)
+     {
+	  return arg.compare(0, 6, "@file:") == 0;
+     }
+
+     //! Map the file named by an "@file:path" argument
+     template <typename T>
+     bool convert(const std::string& arg, MappedArray<T>& value)
+     {
+	  return is_file_arg(arg) && value.map(arg.substr(6));
+     }
+
+     //! Convert the part [begin, end) of an argument into a value
+     template <typename T>
+     bool convert_range(const std::string& arg,
+			std::size_t begin,
+			std::size_t end,
+			T& value)
+     {
+	  return convert(arg.substr(begin, end - begin), value);
+     }
+
+     //! Strings are copied directly from the argument
+     inline bool convert_range(const std::string& arg,
+			       std::size_t begin,
+			       std::size_t end,
+			       std::string& value)
+     {
+	  value.assign(arg, begin, end - begin);
+	  return true;
+     }
+
+     // ========================================================================
+
+     //! Operations depending on the type of a bound value
+     /** Options only keep an untyped pointer to their target along with the
+      *  table of its type: the option classes (matching, bookkeeping, help)
+      *  are defined once in program_options.cpp, whatever the bound type.
+      */
+     struct ValueOps
+     {
+	  //! Convert an argument into the target (inserted for containers)
+	  /** \param index Number of values already consumed by the option
+	   *         (position of the value in fixed-size containers)
+	   */
+	  bool (*consume)(const std::string& arg, void* target,
+			  std::size_t index);
+	  //! Binary encoding of the target (see binary_codec)
+	  bool (*save)(std::vector<char>& out, const void* target);
+	  //! Binary decoding into the target (see binary_codec)
+	  const char* (*restore)(const char* begin, const char* end,
+				 void* target);
+	  //! Target as a number of values (false if not numeric)
+	  bool (*uint_assign)(unsigned int& val, const void* target);
+	  //! Heap-allocated copy of a value (eg. value assigned by a flag)
+	  void* (*clone)(const void* value);
+	  //! Assign a value to the target
+	  void (*assign)(void* target, const void* value);
+	  //! Destroy a value created by clone()
+	  void (*destroy)(void* value);
+	  //! Type of the value (part of the option schema)
+	  const std::type_info& (*type)();
+	  //! Append the elements of the target (the target itself for scalars)
+	  void (*elements)(const void* target, std::vector<const void*>& out);
+	  //! Type of the elements (see Validator)
+	  const std::type_info& (*element_type)();
+	  //! Prepare the target for n more values (NULL if not supported)
+	  void (*reserve)(void* target, std::size_t n);
+	  //! Units accepted by the values (NULL if none, see value_units)
+	  const char* units;
+	  //! Remove all the values of the target (NULL for single values)
+	  void (*clear)(void* target);
+     };
+
+     // ------------------------------------------------------------------------
+
+     //! Operations common to all value types
+     template <typename T>
+     struct value_storage
+     {
+	  static bool save(std::vector<char>& out, const void* target)
+	       {
+		    return binary_codec<T>::write(out,
+						  *static_cast<const T*>(target));
+	       }
+	  static const char* restore(const char* begin,
+				     const char* end,
+				     void* target)
+	       {
+		    return binary_codec<T>::read(begin, end,
+						 *static_cast<T*>(target));
+	       }
+	  static void* clone(const void* value)
+	       {
+		    return new T(*static_cast<const T*>(value));
+	       }
+	  static void assign(void* target, const void* value)
+	       {
+		    *static_cast<T*>(target) = *static_cast<const T*>(value);
+	       }
+	  static void destroy(void* value)
+	       {
+		    delete static_cast<T*>(value);
+	       }
+	  static const std::type_info& type() { return typeid(T); }
+	  static void elements(const void* target,
+			       std::vector<const void*>& out)
+	       {
+		    out.push_back(target);
+	       }
+	  static const std::type_info& element_type() { return typeid(T); }
+     };
+
+     //! Operations for values converted from a single argument
+     template <typename T>
+     struct value_ops : public value_storage<T>
+     {
+	  static bool consume(const std::string& arg, void* target, std::size_t)
+	       {
+		    return convert(arg, *static_cast<T*>(target));
+	       }
+	  static bool uint_assign(unsigned int& val, const void* target)
+	       {
+		    return traits<T>::assign_to(val, *static_cast<const T*>(target));
+	       }
+
+	  static const ValueOps table;
+     };
+
+     template <typename T>
+     const ValueOps value_ops<T>::table = {
+	  &value_ops<T>::consume,
+	  &value_ops<T>::save,
+	  &value_ops<T>::restore,
+	  &value_ops<T>::uint_assign,
+	  &value_ops<T>::clone,
+	  &value_ops<T>::assign,
+	  &value_ops<T>::destroy,
+	  &value_ops<T>::type,
+	  &value_ops<T>::elements,
+	  &value_ops<T>::element_type,
+	  NULL,
+	  value_units<T>::value,
+	  NULL
+     };
+
+     //! Operations for flags (values are assigned, never converted)
+     template <typename T>
+     struct flag_ops : public value_storage<T>
+     {
+	  static bool consume(const std::string&, void*, std::size_t)
+	       {
+		    return false;
+	       }
+	  static bool uint_assign(unsigned int&, const void*) { return false; }
+
+	  static const ValueOps table;
+     };
+
+     template <typename T>
+     const ValueOps flag_ops<T>::table = {
+	  &flag_ops<T>::consume,
+	  &flag_ops<T>::save,
+	  &flag_ops<T>::restore,
+	  &flag_ops<T>::uint_assign,
+	  &flag_ops<T>::clone,
+	  &flag_ops<T>::assign,
+	  &flag_ops<T>::destroy,
+	  &flag_ops<T>::type,
+	  &flag_ops<T>::elements,
+	  &flag_ops<T>::element_type,
+	  NULL,
+	  NULL,
+	  NULL
+     };
+
+     //! Operations for callbacks (the target is a ValueCallback<T>)
+     template <typename T>
+     struct callback_ops : public value_storage< ValueCallback<T> >
+     {
+	  static bool consume(const std::string& arg, void* target, std::size_t)
+	       {
+		    T tmp;
+		    return convert(arg, tmp)
+			 && static_cast<ValueCallback<T>*>(target)->func(tmp);
+	       }
+	  //! Values are not stored and thus cannot be serialized
+	  static bool save(std::vector<char>&, const void*) { return false; }
+	  static const char* restore(const char*, const char*, void*)
+	       {
+		    return NULL;
+	       }
+	  static bool uint_assign(unsigned int&, const void*) { return false; }
+	  static const std::type_info& type() { return typeid(T); }
+	  static void elements(const void*, std::vector<const void*>&) {}
+
+	  static const ValueOps table;
+     };
+
+     template <typename T>
+     const ValueOps callback_ops<T>::table = {
+	  &callback_ops<T>::consume,
+	  &callback_ops<T>::save,
+	  &callback_ops<T>::restore,
+	  &callback_ops<T>::uint_assign,
+	  &callback_ops<T>::clone,
+	  &callback_ops<T>::assign,
+	  &callback_ops<T>::destroy,
+	  &callback_ops<T>::type,
+	  &callback_ops<T>::elements,
+	  &callback_ops<T>::element_type,
+	  NULL,
+	  NULL,
+	  NULL
+     };
+
+     //! Reserve room for n more elements in containers with reserve()
+     template <typename M>
+     auto reserve_more(M& m, std::size_t n, int)
+	  -> decltype(m.reserve(n), void())
+     {
+	  m.reserve(m.size() + n);
+     }
+     template <typename M>
+     void reserve_more(M&, std::size_t, long) {}
+
+     //! Insert a value into a set-like container (duplicates are dropped)
+     template <typename C>
+     auto insert_value(C& c, typename C::value_type& value, std::size_t, int)
+	  -> decltype(c.insert(std::move(value)), bool())
+     {
+	  c.insert(std::move(value));
+	  return true;
+     }
+     //! Append a value to a sequence container
+     template <typename C>
+     bool insert_value(C& c, typename C::value_type& value, std::size_t, long)
+     {
+	  c.push_back(std::move(value));
+	  return true;
+     }
+     //! Store a value at its position in an array (false past its end)
+     template <typename T, std::size_t N>
+     bool insert_value(std::array<T, N>& c, T& value, std::size_t index, int)
+     {
+	  if (index >= N) {
+	       return false;
+	  }
+	  c[index] = std::move(value);
+	  return true;
+     }
+     //! Insert a value at its sorted position unless already present
+     template <typename T>
+     bool insert_value(SortedUniqueVector<T>& c, T& value, std::size_t, int)
+     {
+	  // arguments are often given in order: try appending first
+	  if (c.empty() || c.back() < value) {
+	       c.push_back(std::move(value));
+	       return true;
+	  }
+	  typename std::vector<T>::iterator it(std::lower_bound(c.begin(),
+								c.end(),
+								value));
+	  if (value < *it) {
+	       c.insert(it, std::move(value));
+	  }
+	  return true;
+     }
+
+     //! Call a function with each value of a text file
+     /** Values are separated by commas, blanks or line breaks.
+      *  \return False if the file cannot be read or if f returned false
+      */
+     bool for_each_file_value(const std::string& path,
+			      const std::function<bool (const std::string&)>& f);
+
+     //! Insert the values read from a file (see for_each_file_value())
+     template <typename C>
+     struct file_inserter
+     {
+	  bool operator()(const std::string& arg)
+	       {
+		    typename C::value_type tmp;
+		    return convert(arg, tmp) && insert_value(*c, tmp, index++, 0);
+	       }
+
+	  C* c;
+	  std::size_t index;
+     };
+
+     //! Convert an argument and insert it into a container
+     /** Containers of numbers also take "@file:path" arguments, inserting
+      *  all the values of the file.
+      */
+     template <typename C>
+     bool insert_arg(C& c, const std::string& arg, std::size_t index)
+     {
+	  if (std::is_arithmetic<typename C::value_type>::value
+	      && is_file_arg(arg)) {
+	       const file_inserter<C> inserter = {&c, index};
+	       return for_each_file_value(arg.substr(6), inserter);
+	  }
+	  typename C::value_type tmp;
+	  return convert(arg, tmp) && insert_value(c, tmp, index, 0);
+     }
+     //! Arguments are interned as they are
+     inline bool insert_arg(InternedStrings& c,
+			    const std::string& arg,
+			    std::size_t)
+     {
+	  c.push_back(arg);
+	  return true;
+     }
+
+     template <typename C>
+     void clear_values(C& c) { c.clear(); }
+     //! Arrays keep their size: values are overwritten instead
+     template <typename T, std::size_t N>
+     void clear_values(std::array<T, N>&) {}
+
+     template <typename C>
+     void collect_elements(const C& c, std::vector<const void*>& out)
+     {
+	  for (typename C::const_iterator it(c.begin()); it != c.end(); ++it) {
+	       out.push_back(&*it);
+	  }
+     }
+     //! Elements of bit vectors cannot be addressed (and are not validated)
+     template <typename A>
+     void collect_elements(const std::vector<bool, A>&,
+			   std::vector<const void*>&)
+     {}
+
+     //! Containers stored as a 64-bit count followed by their elements
+     template <typename C>
+     bool write_values(std::vector<char>& out, const C& c)
+     {
+	  binary_codec<std::uint64_t>::write(out, c.size());
+	  for (typename C::const_iterator it(c.begin()); it != c.end(); ++it) {
+	       if (!binary_codec<typename C::value_type>::write(out, *it)) {
+		    return false;
+	       }
+	  }
+	  return true;
+     }
+     template <typename T>
+     bool write_values(std::vector<char>& out, const std::vector<T>& c)
+     {
+	  return binary_codec< std::vector<T> >::write(out, c);
+     }
+     template <typename T>
+     bool write_values(std::vector<char>& out, const SortedUniqueVector<T>& c)
+     {
+	  return binary_codec< std::vector<T> >::write(out, c);
+     }
+
+     //! Interned strings are stored as strings (handles are addresses)
+     inline bool write_values(std::vector<char>& out, const InternedStrings& c)
+     {
+	  binary_codec<std::uint64_t>::write(out, c.size());
+	  for (std::size_t i(0); i < c.size(); ++i) {
+	       binary_codec<std::uint64_t>::write(out, c[i].size());
+	       out.insert(out.end(), c[i].c_str(), c[i].c_str() + c[i].size());
+	  }
+	  return true;
+     }
+
+     template <typename C>
+     const char* read_values(const char* begin, const char* end, C& c)
+     {
+	  std::uint64_t size(0);
+	  begin = binary_codec<std::uint64_t>::read(begin, end, size);
+	  clear_values(c);
+	  for (std::size_t i(0); begin != NULL && i < size; ++i) {
+	       typename C::value_type tmp;
+	       begin = binary_codec<typename C::value_type>::read(begin, end, tmp);
+	       if (begin != NULL && !insert_value(c, tmp, i, 0)) {
+		    return NULL;
+	       }
+	  }
+	  return begin;
+     }
+     template <typename T>
+     const char* read_values(const char* begin,
+			     const char* end,
+			     std::vector<T>& c)
+     {
+	  return binary_codec< std::vector<T> >::read(begin, end, c);
+     }
+     //! Snapshots of sorted vectors are restored as they were saved
+     template <typename T>
+     const char* read_values(const char* begin,
+			     const char* end,
+			     SortedUniqueVector<T>& c)
+     {
+	  return binary_codec< std::vector<T> >::read(begin, end, c);
+     }
+
+     inline const char* read_values(const char* begin,
+				    const char* end,
+				    InternedStrings& c)
+     {
+	  std::uint64_t size(0);
+	  begin = binary_codec<std::uint64_t>::read(begin, end, size);
+	  c.clear();
+	  std::string tmp;
+	  for (; begin != NULL && size > 0; --size) {
+	       begin = binary_codec<std::string>::read(begin, end, tmp);
+	       if (begin != NULL) {
+		    c.push_back(tmp);
+	       }
+	  }
+	  return begin;
+     }
+
+     //! Operations for containers (each argument is converted in place)
+     /** Supported containers are sequences with push_back() (eg. std::vector
+      *  or std::deque), sets (duplicates are dropped when inserted),
+      *  std::array (filled up to its size), SortedUniqueVector and
+      *  InternedStrings.
+      */
+     template <typename C>
+     struct container_ops : public value_storage<C>
+     {
+	  typedef typename C::value_type value_type;
+
+	  static bool consume(const std::string& arg,
+			      void* target,
+			      std::size_t index)
+	       {
+		    return insert_arg(*static_cast<C*>(target), arg, index);
+	       }
+	  static bool save(std::vector<char>& out, const void* target)
+	       {
+		    return write_values(out, *static_cast<const C*>(target));
+	       }
+	  static const char* restore(const char* begin,
+				     const char* end,
+				     void* target)
+	       {
+		    return read_values(begin, end, *static_cast<C*>(target));
+	       }
+	  static bool uint_assign(unsigned int&, const void*) { return false; }
+	  static void elements(const void* target,
+			       std::vector<const void*>& out)
+	       {
+		    collect_elements(*static_cast<const C*>(target), out);
+	       }
+	  static const std::type_info& element_type()
+	       {
+		    return typeid(value_type);
+	       }
+	  static void reserve(void* target, std::size_t n)
+	       {
+		    reserve_more(*static_cast<C*>(target), n, 0);
+	       }
+	  static void clear(void* target)
+	       {
+		    clear_values(*static_cast<C*>(target));
+	       }
+
+	  static const ValueOps table;
+     };
+
+     template <typename C>
+     const ValueOps container_ops<C>::table = {
+	  &container_ops<C>::consume,
+	  &container_ops<C>::save,
+	  &container_ops<C>::restore,
+	  &container_ops<C>::uint_assign,
+	  &container_ops<C>::clone,
+	  &container_ops<C>::assign,
+	  &container_ops<C>::destroy,
+	  &container_ops<C>::type,
+	  &container_ops<C>::elements,
+	  &container_ops<C>::element_type,
+	  &container_ops<C>::reserve,
+	  value_units<typename C::value_type>::value,
+	  &container_ops<C>::clear
+     };
+
+     //! Operations for maps filled with "key=value" arguments
+     template <typename M, KEY_POLICY policy>
+     struct map_ops : public value_storage<M>
+     {
+	  typedef typename M::key_type key_type;
+	  typedef typename M::mapped_type mapped_type;
+
+	  static bool consume(const std::string& arg, void* target, std::size_t)
+	       {
+		    M& m(*static_cast<M*>(target));
+		    const std::size_t eq(arg.find('='));
+		    key_type key;
+		    mapped_type value;
+		    if (eq == std::string::npos
+			|| !convert_range(arg, 0, eq, key)
+			|| !convert_range(arg, eq + 1, arg.size(), value)) {
+			 return false;
+		    }
+
+		    typename M::iterator it(m.find(key));
+		    if (it == m.end()) {
+			 m.insert(typename M::value_type(std::move(key),
+							 std::move(value)));
+		    }
+		    else if (policy == UNIQUE_KEYS) {
+			 return false;
+		    }
+		    else {
+			 it->second = std::move(value);
+		    }
+		    return true;
+	       }
+	  //! Stored as a 64-bit count followed by the key/value pairs
+	  static bool save(std::vector<char>& out, const void* target)
+	       {
+		    const M& m(*static_cast<const M*>(target));
+		    binary_codec<std::uint64_t>::write(out, m.size());
+		    for (typename M::const_iterator it(m.begin()); it != m.end(); ++it) {
+			 if (!binary_codec<key_type>::write(out, it->first)
+			     || !binary_codec<mapped_type>::write(out, it->second)) {
+			      return false;
+			 }
+		    }
+		    return true;
+	       }
+	  static const char* restore(const char* begin,
+				     const char* end,
+				     void* target)
+	       {
+		    M& m(*static_cast<M*>(target));
+		    std::uint64_t size(0);
+		    begin = binary_codec<std::uint64_t>::read(begin, end, size);
+		    m.clear();
+		    for (; begin != NULL && size > 0; --size) {
+			 key_type key;
+			 mapped_type value;
+			 begin = binary_codec<key_type>::read(begin, end, key);
+			 if (begin != NULL) {
+			      begin = binary_codec<mapped_type>::read(begin, end,
+								      value);
+			 }
+			 if (begin != NULL) {
+			      m[key] = value;
+			 }
+		    }
+		    return begin;
+	       }
+	  static bool uint_assign(unsigned int&, const void*) { return false; }
+	  static void reserve(void* target, std::size_t n)
+	       {
+		    reserve_more(*static_cast<M*>(target), n, 0);
+	       }
+	  static void clear(void* target)
+	       {
+		    static_cast<M*>(target)->clear();
+	       }
+
+	  static const ValueOps table;
+     };
+
+     template <typename M, KEY_POLICY policy>
+     const ValueOps map_ops<M, policy>::table = {
+	  &map_ops<M, policy>::consume,
+	  &map_ops<M, policy>::save,
+	  &map_ops<M, policy>::restore,
+	  &map_ops<M, policy>::uint_assign,
+	  &map_ops<M, policy>::clone,
+	  &map_ops<M, policy>::assign,
+	  &map_ops<M, policy>::destroy,
+	  &map_ops<M, policy>::type,
+	  &map_ops<M, policy>::elements,
+	  &map_ops<M, policy>::element_type,
+	  &map_ops<M, policy>::reserve,
+	  NULL,
+	  &map_ops<M, policy>::clear
+     };
+
+     // ========================================================================
+
+     /*
+      * Options of each kind (defined in program_options.cpp); target points
+      * to the bound value, whose type is described by ops.
+      */
+
+     //! Named option with one value
+     OptionValueBase* make_named_value(const char* s_name,
+				       const char* l_name,
+				       const char* h_name,
+				       void* target,
+				       const ValueOps& ops,
+				       const char* desc,
+				       bool required);
+     //! Named option with count values per occurrence
+     OptionValueBase* make_named_vector(const char* s_name,
+					const char* l_name,
+					const char* h_name,
+					void* target,
+					const ValueOps& ops,
+					unsigned int count,
+					const char* desc,
+					bool required);
+     //! Named option without value assigning value to the target
+     OptionValueBase* make_flag(const char* s_name,
+				const char* l_name,
+				const char* h_name,
+				void* target,
+				const void* value,
+				const ValueOps& ops,
+				const char* desc,
+				bool required);
+     //! Named option assigning the value of the choice named by its argument
+     /** \param names Names of the choices
+      *  \param values Values of the choices (copied with ops.clone())
+      */
+     OptionValueBase* make_choice(const char* s_name,
+				  const char* l_name,
+				  const char* h_name,
+				  void* target,
+				  const ValueOps& ops,
+				  const std::vector<const char*>& names,
+				  const std::vector<const void*>& values,
+				  const char* desc,
+				  bool required);
+     //! Positional option with one value
+     OptionValueBase* make_positional_value(const char* h_name,
+					    void* target,
+					    const ValueOps& ops,
+					    const char* desc,
+					    bool required);
+     //! Positional option assigning the value of the choice it names
+     OptionValueBase* make_positional_choice(const char* h_name,
+					     void* target,
+					     const ValueOps& ops,
+					     const std::vector<const char*>& names,
+					     const std::vector<const void*>& values,
+					     const char* desc,
+					     bool required);
+     //! Positional option with several values
+     /** \param max_count Number of values (-1 for all the arguments but the
+      *         last one, 0 if it depends on another option)
+      */
+     OptionValueBase* make_positional_vector(const char* h_name,
+					     void* target,
+					     const ValueOps& ops,
+					     int max_count,
+					     const CountDependentOption& dependent,
+					     const char* desc,
+					     bool required);
+     //! Positional option handing each value to a callback
+     OptionValueBase* make_positional_callback(const char* h_name,
+					       const void* callback,
+					       const ValueOps& ops,
+					       const char* desc,
+					       bool required);
+
+     // ------------------------------------------------------------------------
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 T& value,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_named_value(short_name, long_name, long_name,
+				  &value, value_ops<T>::table,
+				  desc, required);
+     }
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* s_name,
+				 const char* l_name,
+				 const char* h_name,
+				 T& value,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_named_value(s_name, l_name, h_name,
+				  &value, value_ops<T>::table,
+				  desc, required);
+     }
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 T& value,
+				 T value_to_assign,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_flag(short_name, long_name, long_name,
+			   &value, &value_to_assign, flag_ops<T>::table,
+			   desc, required);
+     }
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* s_name,
+				 const char* l_name,
+				 const char* h_name,
+				 T& value,
+				 T value_to_assign,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_flag(s_name, l_name, h_name,
+			   &value, &value_to_assign, flag_ops<T>::table,
+			   desc, required);
+     }
+
+     inline const char* choice_name(const char* name) { return name; }
+     inline const char* choice_name(const std::string& name)
+     {
+	  return name.c_str();
+     }
+
+     template <typename L>
+     std::vector<const char*> choice_names(const L& choices)
+     {
+	  std::vector<const char*> names;
+	  names.reserve(choices.size());
+	  for (typename L::const_iterator it(choices.begin())
+		    ; it != choices.end() ; ++it) {
+	       names.push_back(choice_name(it->first));
+	  }
+	  return names;
+     }
+
+     //! Splits a list of choices into names and pointers to their values
+     template <typename L>
+     void split_choices(const L& choices,
+			std::vector<const char*>& names,
+			std::vector<const void*>& values)
+     {
+	  names.reserve(choices.size());
+	  values.reserve(choices.size());
+	  for (typename L::const_iterator it(choices.begin())
+		    ; it != choices.end() ; ++it) {
+	       names.push_back(choice_name(it->first));
+	       values.push_back(&it->second);
+	  }
+     }
+
+     //! Helper function to ease the creating of choice options
+     /** Choices are assigned like flag values, never converted
+      */
+     template <typename T, typename L>
+     OptionValueBase* make_choices(const char* short_name,
+				   const char* long_name,
+				   T& value,
+				   const L& choices,
+				   const char* desc,
+				   bool required)
+     {
+	  std::vector<const char*> names;
+	  std::vector<const void*> values;
+	  split_choices(choices, names, values);
+	  return make_choice(short_name, long_name, long_name,
+			     &value, flag_ops<T>::table, names, values,
+			     desc, required);
+     }
+
+     //! Helper function to ease the creating of choice options
+     template <typename T, typename L>
+     OptionValueBase* make_choices(const char* help_name,
+				   T& value,
+				   const L& choices,
+				   const char* desc,
+				   bool required)
+     {
+	  std::vector<const char*> names;
+	  std::vector<const void*> values;
+	  split_choices(choices, names, values);
+	  return make_positional_choice(help_name, &value, flag_ops<T>::table,
+					names, values, desc, required);
+     }
+
+     //! Helper function to ease the creating of options
+     /** Map options are named options taking one value per occurrence
+      */
+     template <typename M>
+     OptionValueBase* make_value(const char* short_name,
+				 const char* long_name,
+				 M& value,
+				 KEY_POLICY policy,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_named_vector(short_name, long_name, long_name, &value,
+				   policy == UNIQUE_KEYS
+				   ? map_ops<M, UNIQUE_KEYS>::table
+				   : map_ops<M, LAST_WINS>::table,
+				   1, desc, required);
+     }
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* help_name,
+				 T& value,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_positional_value(help_name, &value, value_ops<T>::table,
+				       desc, required);
+     }
+
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* short_name,
+				     const char* long_name,
+				     C& value,
+				     unsigned int count,
+				     const char* desc,
+				     bool required)
+     {
+	  return make_named_vector(short_name, long_name, long_name,
+				   &value, container_ops<C>::table,
+				   count, desc, required);
+     }
+
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* help_name,
+				     C& value,
+				     unsigned int count,
+				     const char* desc,
+				     bool required)
+     {
+	  return make_positional_vector(help_name,
+					&value,
+					container_ops<C>::table,
+					count,
+					CountDependentOption("", INVALID_FUNC, false),
+					desc,
+					required);
+     }
+
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* help_name,
+				     C& value,
+				     const CountDependentOption& dependent,
+				     const char* desc,
+				     bool required)
+     {
+	  return make_positional_vector(help_name,
+					&value,
+					container_ops<C>::table,
+					0,
+					dependent,
+					desc,
+					required);
+     }
+     
+     //! Helper function to ease the creating of container options
+     template <typename C>
+     OptionValueBase* make_container(const char* help_name,
+				     C& value,
+				     const AnythingButLast&,
+				     const char* desc,
+				     bool required)
+     {
+	  return make_positional_vector(help_name,
+					&value,
+					container_ops<C>::table,
+					-1,
+					CountDependentOption("", INVALID_FUNC, false),
+					desc,
+					required);
+     }
+
+     //! Helper function to ease the creating of options
+     template <typename T>
+     OptionValueBase* make_value(const char* help_name,
+				 const ValueCallback<T>& callback,
+				 const char* desc,
+				 bool required)
+     {
+	  return make_positional_callback(help_name, &callback,
+					  callback_ops<T>::table,
+					  desc, required);
+     }
+
+     // ------------------------------------------------------------------------
+
+     template <typename T>
+     StaticOption::StaticOption(const char* short_name,
+				const char* long_name,
+				T& value,
+				const char* desc,
+				bool required)
+	  : short_name_(short_name)
+	  , long_name_(long_name)
+	  , desc_(desc)
+	  , target_(&value)
+	  , ops_(&value_ops<T>::table)
+	  , count_(0)
+	  , switch_(false)
+	  , required_(required)
+	  , next_(NULL)
+     {
+	  register_();
+     }
+
+     template <typename C>
+     StaticOption::StaticOption(const char* short_name,
+				const char* long_name,
+				C& value,
+				unsigned int count,
+				const char* desc,
+				bool required)
+	  : short_name_(short_name)
+	  , long_name_(long_name)
+	  , desc_(desc)
+	  , target_(&value)
+	  , ops_(&container_ops<C>::table)
+	  , count_(count)
+	  , switch_(false)
+	  , required_(required)
+	  , next_(NULL)
+     {
+	  register_();
+     }
+
+     // ------------------------------------------------------------------------
+
+     //! Value tables instantiated once in program_options.cpp
+#define PROGRAM_OPTIONS_OPS_TEMPLATES(EXTERN, T)			\
+     EXTERN template struct value_ops<T>;				\
+     EXTERN template struct container_ops< std::vector<T> >;		\
+     EXTERN template struct flag_ops<T>;				\
+     EXTERN template struct callback_ops<T>
+
+     extern template struct flag_ops<bool>;
+     PROGRAM_OPTIONS_OPS_TEMPLATES(extern, int);
+     PROGRAM_OPTIONS_OPS_TEMPLATES(extern, unsigned int);
+     PROGRAM_OPTIONS_OPS_TEMPLATES(extern, double);
+     PROGRAM_OPTIONS_OPS_TEMPLATES(extern, std::string);
+} // namespace internal_
+
+#endif //PROGRAM_OPTIONS_IMPL_HPP_INCLUDED
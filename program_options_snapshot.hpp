@@ -0,0 +1,178 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+#ifndef PROGRAM_OPTIONS_SNAPSHOT_HPP_INCLUDED
+#define PROGRAM_OPTIONS_SNAPSHOT_HPP_INCLUDED
+
+#include "program_options.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+//! Class publishing immutable parse results to concurrent readers
+/** Each call to reload() parses the arguments into a fresh T (bound to a
+ *  fresh ProgramOptionManager by the user-supplied binder function) and,
+ *  on success, atomically replaces the current snapshot with it.
+ *
+ *  Readers access the current snapshot through a ReadGuard. Acquiring and
+ *  releasing a guard is wait-free (one atomic load, one increment, one
+ *  decrement) and never blocks on a concurrent reload. The writer retires
+ *  the previous snapshot only once every reader that could have seen it
+ *  has released its guard (two-phase epoch flip, similar to userspace RCU).
+ */
+template <typename T>
+class OptionSnapshot
+{
+public:
+     //! Function binding the members of a T to the options of a manager
+     typedef void (*binder_type)(ProgramOptionManager&, T&);
+
+     //! RAII object pinning a snapshot for the duration of its lifetime
+     class ReadGuard
+     {
+     public:
+	  ReadGuard(ReadGuard&& rhs)
+	       : counter_(rhs.counter_)
+	       , value_(rhs.value_)
+	       {
+		    rhs.counter_ = NULL;
+		    rhs.value_ = NULL;
+	       }
+	  ~ReadGuard()
+	       {
+		    if (counter_ != NULL) {
+			 counter_->fetch_sub(1, std::memory_order_release);
+		    }
+	       }
+
+	  //! Simple getter function (NULL if nothing was published yet)
+	  const T* get() const { return value_; }
+	  const T& operator*() const { return *value_; }
+	  const T* operator->() const { return value_; }
+
+     private:
+	  friend class OptionSnapshot;
+
+	  ReadGuard(std::atomic<unsigned int>* counter, const T* value)
+	       : counter_(counter)
+	       , value_(value)
+	       {}
+	  ReadGuard(const ReadGuard&);
+	  ReadGuard& operator=(const ReadGuard&);
+
+	  std::atomic<unsigned int>* counter_;
+	  const T* value_;
+     };
+
+     //! Constructor
+     /** \param prog_name Program name used for each underlying manager
+      *  \param desc Program description used for each underlying manager
+      *  \param binder Function registering the options for a given T
+      *  \param defaults Initial value of T before each parse
+      */
+     OptionSnapshot(const char* prog_name,
+		    const char* desc,
+		    binder_type binder,
+		    const T& defaults = T())
+	  : prog_name_(prog_name)
+	  , desc_(desc)
+	  , binder_(binder)
+	  , defaults_(defaults)
+	  , current_(NULL)
+	  , epoch_(0)
+	  , generation_(0)
+	  {
+	       readers_[0] = 0;
+	       readers_[1] = 0;
+	  }
+
+     //! Destructor
+     /** \note No ReadGuard may outlive the OptionSnapshot
+      */
+     ~OptionSnapshot()
+	  {
+	       delete current_.load();
+	  }
+
+     //! Pin the current snapshot
+     ReadGuard read() const
+	  {
+	       std::atomic<unsigned int>& counter(readers_[epoch_.load() & 1]);
+	       counter.fetch_add(1);
+	       return ReadGuard(&counter, current_.load());
+	  }
+
+     //! Parse a new snapshot and publish it
+     /** \return Same as ProgramOptionManager::process_arguments(). The
+      *          snapshot is only published if the return value is >0.
+      *  \note Concurrent calls to reload() are serialized, readers are never
+      *        blocked.
+      */
+     int reload(int argc, char** argv)
+	  {
+	       T* value(new T(defaults_));
+	       int retval(0);
+	       {
+		    ProgramOptionManager manager(prog_name_.c_str(),
+						 desc_.c_str());
+		    binder_(manager, *value);
+		    retval = manager.process_arguments(argc, argv);
+	       }
+
+	       if (retval <= 0) {
+		    delete value;
+		    return retval;
+	       }
+
+	       std::lock_guard<std::mutex> lock(writer_mutex_);
+	       const T* old(current_.exchange(value));
+	       ++generation_;
+	       synchronize_();
+	       delete old;
+	       return retval;
+	  }
+
+     //! Number of snapshots published so far
+     unsigned long generation() const
+	  {
+	       std::lock_guard<std::mutex> lock(writer_mutex_);
+	       return generation_;
+	  }
+
+private:
+     OptionSnapshot(const OptionSnapshot&);
+     OptionSnapshot& operator=(const OptionSnapshot&);
+
+     //! Wait for all readers that may still hold the previous snapshot
+     /** Flipping the epoch twice and draining each parity guarantees that
+      *  every guard acquired before the pointer exchange has been released.
+      */
+     void synchronize_()
+	  {
+	       for (unsigned int phase(0); phase < 2; ++phase) {
+		    unsigned int old_epoch(epoch_.fetch_add(1));
+		    while (readers_[old_epoch & 1].load(std::memory_order_acquire) != 0) {
+			 std::this_thread::yield();
+		    }
+	       }
+	  }
+
+     std::string prog_name_;
+     std::string desc_;
+     binder_type binder_;
+     T defaults_;
+
+     std::atomic<const T*> current_;
+     std::atomic<unsigned int> epoch_;
+     mutable std::atomic<unsigned int> readers_[2];
+     mutable std::mutex writer_mutex_;
+     unsigned long generation_;
+};
+
+#endif //PROGRAM_OPTIONS_SNAPSHOT_HPP_INCLUDED
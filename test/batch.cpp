@@ -0,0 +1,97 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options_batch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct job {
+     job() : n(0), b(false) {}
+
+     unsigned int n;
+     bool b;
+     std::vector<double> v;
+     std::string input;
+};
+
+void bind_job(ProgramOptionManager& args, job& j)
+{
+     args.add_option("input", j.input, "input file");
+     args.add_option("n", "number", j.n, "a number");
+     args.add_option("b", "bool", j.b, "a flag");
+     args.add_option("v", "vector", j.v, 2, "two values");
+}
+
+int main()
+{
+     const std::size_t n_lines(20000);
+     std::vector<BatchParser<job>::argument_list> lines(n_lines);
+     for (std::size_t l(0); l < n_lines; ++l) {
+	  std::ostringstream ssout;
+	  ssout << l;
+	  lines[l].push_back("-n");
+	  lines[l].push_back(ssout.str());
+	  if (l % 2 == 0) {
+	       lines[l].push_back("-b");
+	  }
+	  if (l % 7 == 0) {
+	       lines[l].push_back("--bogus");
+	  }
+	  lines[l].push_back("-v");
+	  lines[l].push_back("1.5");
+	  lines[l].push_back(ssout.str());
+	  lines[l].push_back("file" + ssout.str());
+     }
+
+     BatchParser<job> parser("batch", "", bind_job, job(), 4);
+     std::vector<BatchParser<job>::Result> results(parser.parse(lines, 64));
+
+     if (results.size() != n_lines) {
+	  return -1;
+     }
+     for (std::size_t l(0); l < n_lines; ++l) {
+	  const BatchParser<job>::Result& r(results[l]);
+	  if (l % 7 == 0) {
+	       if (r.retval >= 0 || r.error.empty()) {
+		    std::cerr << "ERROR: line " << l << " should have failed\n";
+		    return -1;
+	       }
+	       continue;
+	  }
+
+	  std::ostringstream ssout;
+	  ssout << "file" << l;
+	  if (r.retval <= 0 || !r.error.empty()
+	      || r.value.n != l
+	      || r.value.b != (l % 2 == 0)
+	      || r.value.v.size() != 2
+	      || r.value.v[1] != static_cast<double>(l)
+	      || r.value.input != ssout.str()) {
+	       std::cerr << "ERROR: wrong result for line " << l << std::endl;
+	       return -1;
+	  }
+     }
+
+     // help is reported in the result of its line, not on std::cout
+     std::vector<BatchParser<job>::argument_list> help_lines(2);
+     help_lines[0].push_back("-n");
+     help_lines[0].push_back("1");
+     help_lines[0].push_back("file");
+     help_lines[1].push_back("-h");
+     results = parser.parse(help_lines);
+     if (results[0].retval <= 0 || !results[0].output.empty()
+	 || results[1].retval != 0
+	 || results[1].output.find("usage: batch") != 0) {
+	  std::cerr << "ERROR: help not reported in the result" << std::endl;
+	  return -1;
+     }
+     return 0;
+}
@@ -0,0 +1,93 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum some_type {
+     ONE = 1,
+     TWO = 2,
+};
+
+struct values {
+     values() : b(false), u(0), d(0.), st(ONE) {}
+
+     bool b;
+     unsigned int u;
+     double d;
+     some_type st;
+     std::string s;
+     std::vector<int> v;
+     std::vector<std::string> files;
+
+     bool operator==(const values& rhs) const
+	  {
+	       return b == rhs.b && u == rhs.u && d == rhs.d && st == rhs.st
+		    && s == rhs.s && v == rhs.v && files == rhs.files;
+	  }
+};
+
+void bind(ProgramOptionManager& args, values& val)
+{
+     args.add_option("u", val.u, "a number");
+     args.add_option("files", val.files, count_depends_on("u"), "some files");
+     args.add_option("b", "bool", val.b, "a boolean flag");
+     args.add_option("d", "double", val.d, "a double");
+     args.add_option("s", "string", val.s, "a string");
+     args.add_option("v", "vector", val.v, 3, "an argument with 3 values");
+     args.add_option("T", "TWO", val.st, TWO, "a flag with specific value TWO");
+}
+
+int main(int argc, char* argv[])
+{
+     const char* filename(argc > 1 ? argv[1] : "binary_snapshot_test.bin");
+
+     values parsed;
+     {
+	  const char* args[] = {"prog", "-T", "-d", "2.5", "-s", "hello",
+				"-v", "1", "2", "3", "2", "a.cpp", "b.cpp"};
+	  ProgramOptionManager manager("prog", "");
+	  bind(manager, parsed);
+	  if (manager.process_arguments(13, const_cast<char**>(args)) <= 0
+	      || !manager.save_snapshot(filename)) {
+	       std::cerr << "ERROR: unable to create snapshot\n";
+	       return -1;
+	  }
+     }
+
+     values restored;
+     {
+	  ProgramOptionManager manager("prog", "");
+	  bind(manager, restored);
+	  if (manager.restore_snapshot(filename) <= 0) {
+	       return -1;
+	  }
+     }
+     if (!(restored == parsed) || restored.files.size() != 2) {
+	  std::cerr << "ERROR: restored values differ from parsed values\n";
+	  return -1;
+     }
+
+     {
+	  values other;
+	  ProgramOptionManager manager("prog", "");
+	  bind(manager, other);
+	  manager.add_option("x", "extra", other.u, "an extra option");
+	  if (manager.restore_snapshot(filename) > 0) {
+	       std::cerr << "ERROR: snapshot with different schema accepted\n";
+	       return -1;
+	  }
+     }
+
+     std::remove(filename);
+     return 0;
+}
@@ -0,0 +1,41 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+#ifndef PROGRAM_OPTIONS_TEST_CHECK_HPP_INCLUDED
+#define PROGRAM_OPTIONS_TEST_CHECK_HPP_INCLUDED
+
+/*
+ * Helpers shared by the tests (usable with PROGRAM_OPTIONS_NO_IOSTREAM).
+ */
+
+#include "program_options_decl.hpp"
+
+#include <cstddef>
+#include <cstdio>
+
+//! Report a failed check
+/** \return Number of errors (0 or 1)
+ */
+inline int check(bool condition, const char* message)
+{
+     if (!condition) {
+	  std::fprintf(stderr, "ERROR: %s\n", message);
+	  return 1;
+     }
+     return 0;
+}
+
+//! Process a NULL-terminated array of arguments (program name first)
+template <std::size_t N>
+int process(ProgramOptionManager& args, const char* (&argv)[N])
+{
+     return args.process_arguments(static_cast<int>(N - 1),
+				   const_cast<char**>(argv));
+}
+
+#endif //PROGRAM_OPTIONS_TEST_CHECK_HPP_INCLUDED
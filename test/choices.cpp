@@ -0,0 +1,121 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+enum speed { FAST, BALANCED, SAFE };
+
+int main()
+{
+     int errors(0);
+
+     // names are mapped to their values
+     {
+	  speed mode(BALANCED);
+	  speed level(FAST);
+	  ProgramOptionManager args("choices", "");
+	  args.add_option("m", "mode", mode,
+			  {{"fast", FAST}, {"balanced", BALANCED}, {"safe", SAFE}},
+			  "processing mode");
+	  args.add_option("level", level,
+			  {{"low", FAST}, {"high", SAFE}}, "level");
+	  const char* argv[] = {"choices", "--mode", "safe", "high", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(mode == SAFE, "wrong named choice");
+	  errors += check(level == SAFE, "wrong positional choice");
+     }
+
+     // help lists the choices
+     {
+	  speed mode(BALANCED);
+	  ProgramOptionManager args("choices", "");
+	  args.add_option("m", "mode", mode,
+			  {{"fast", FAST}, {"balanced", BALANCED}, {"safe", SAFE}},
+			  "processing mode");
+	  errors += check(args.help_text().find("choices: fast, balanced, safe")
+			  != std::string::npos,
+			  "choices missing from help");
+     }
+
+     // other names are rejected with the list of valid values
+     {
+	  speed mode(BALANCED);
+	  std::ostringstream err;
+	  ProgramOptionManager args("choices", "");
+	  args.set_error_stream(err);
+	  args.add_option("m", "mode", mode,
+			  {{"fast", FAST}, {"balanced", BALANCED}, {"safe", SAFE}},
+			  "processing mode");
+	  const char* argv[] = {"choices", "-m", "slow", NULL};
+	  errors += check(process(args, argv) < 0
+			  && args.last_error().code == ParseEvent::INVALID_VALUE,
+			  "unknown choice accepted");
+	  errors += check(err.str().find("(valid values: fast, balanced, safe)")
+			  != std::string::npos,
+			  "valid values missing from error");
+	  errors += check(mode == BALANCED, "value changed by unknown choice");
+     }
+
+     // empty lists and repeated names are rejected at registration
+     {
+	  speed mode(BALANCED);
+	  std::ostringstream err;
+	  ProgramOptionManager args("choices", "");
+	  args.set_error_stream(err);
+	  args.add_option("m", "mode", mode,
+			  {{"fast", FAST}, {"safe", SAFE}, {"fast", SAFE}},
+			  "processing mode");
+	  args.add_option("l", "level", mode,
+			  std::vector<std::pair<std::string, speed> >(),
+			  "level");
+	  errors += check(err.str().find("choice fast given more than once "
+					 "for mode!") != std::string::npos,
+			  "repeated choice accepted");
+	  errors += check(err.str().find("no choices given for level!")
+			  != std::string::npos,
+			  "empty choices accepted");
+	  errors += check(args.help_text().find("--mode") == std::string::npos
+			  && args.help_text().find("--level") == std::string::npos,
+			  "invalid choice options added");
+     }
+
+     // hundreds of choices built at runtime, each found
+     {
+	  std::vector<std::pair<std::string, int> > list;
+	  for (int i(0) ; i < 500 ; ++i) {
+	       list.push_back(std::make_pair("choice" + std::to_string(i), i));
+	  }
+	  int value(-1);
+	  std::ostringstream err;
+	  ProgramOptionManager args("choices", "");
+	  args.set_error_stream(err);
+	  args.add_option("c", "choice", value, list, "one of many");
+	  int found(0);
+	  for (int i(0) ; i < 500 ; ++i) {
+	       const std::string name("choice" + std::to_string(i));
+	       const char* argv[] = {"choices", "-c", name.c_str(), NULL};
+	       found += process(args, argv) > 0
+		    && value == i;
+	       args.reset();
+	  }
+	  errors += check(found == 500, "choice not found among many");
+
+	  const char* argv[] = {"choices", "-c", "choice500", NULL};
+	  errors += check(process(args, argv) < 0,
+			  "unknown choice accepted among many");
+     }
+
+     return errors;
+}
@@ -0,0 +1,119 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//! Split a command line into words
+std::vector<std::string> split(const char* command, bool* failed = NULL)
+{
+     std::vector<char> buffer(command, command + std::strlen(command) + 1);
+     CommandLineSource source(&buffer[0]);
+     std::vector<std::string> words;
+     std::string word;
+     while (source.next(word)) {
+	  words.push_back(word);
+     }
+     if (failed != NULL) {
+	  *failed = source.failed();
+     }
+     return words;
+}
+
+int main()
+{
+     int errors(0);
+
+     // shell quoting rules
+     {
+	  std::vector<std::string> words(split("  a\tb\n c  "));
+	  errors += check(words.size() == 3 && words[0] == "a" && words[1] == "b"
+			  && words[2] == "c",
+			  "blanks not separating words");
+
+	  words = split("'a b' \"c d\" e\\ f 'g'\"h\"i");
+	  errors += check(words.size() == 4 && words[0] == "a b"
+			  && words[1] == "c d" && words[2] == "e f"
+			  && words[3] == "ghi",
+			  "quotes not removed");
+
+	  words = split("\"\\$x \\\" \\\\ \\n\" '\\n' \\n");
+	  errors += check(words.size() == 3 && words[0] == "$x \" \\ \\n"
+			  && words[1] == "\\n" && words[2] == "n",
+			  "backslashes not handled like a shell");
+
+	  words = split("'' \"\" a\\\nb \"c\\\nd\"");
+	  errors += check(words.size() == 4 && words[0].empty() && words[1].empty()
+			  && words[2] == "ab" && words[3] == "cd",
+			  "empty words or line continuations not handled");
+
+	  bool failed(false);
+	  split("a 'b", &failed);
+	  errors += check(failed, "unterminated single quote accepted");
+	  split("a \"b\\\"", &failed);
+	  errors += check(failed, "unterminated double quote accepted");
+     }
+
+     // words are split in place
+     {
+	  char command[] = "prog 'a b' c";
+	  CommandLineSource source(command);
+	  std::size_t size(0);
+	  const char* prog(source.next_word(size));
+	  const char* first(source.next_word(size));
+	  errors += check(prog == command && std::strcmp(prog, "prog") == 0
+			  && first == command + 5 && size == 3
+			  && std::strcmp(first, "a b") == 0,
+			  "words not split in place");
+     }
+
+     // parsing a command line
+     {
+	  int n(0);
+	  std::string path;
+	  std::vector<std::string> files;
+	  ProgramOptionManager args("cmd", "");
+	  args.add_option("n", "number", n, "a number");
+	  args.add_option("p", "path", path, "a path");
+	  args.add_option("files", files, 2, "two files");
+
+	  char command[] = "cmd -n 3 --path '/tmp/my '\"dir\" 'a c' \\b";
+	  errors += check(args.process_command_line(command) > 0, "parsing failed");
+	  errors += check(n == 3 && path == "/tmp/my dir"
+			  && files.size() == 2 && files[0] == "a c"
+			  && files[1] == "b",
+			  "wrong values from the command line");
+     }
+     {
+	  int n(0);
+	  ProgramOptionManager args("cmd", "");
+	  args.add_option("n", "number", n, "a number");
+	  errors += check(args.process_command_line(std::string("cmd -n 4")) > 0
+			  && n == 4,
+			  "parsing a constant command line failed");
+     }
+     {
+	  std::ostringstream err;
+	  int n(0);
+	  ProgramOptionManager args("cmd", "");
+	  args.set_error_stream(err);
+	  args.add_option("n", "number", n, "a number");
+	  errors += check(args.process_command_line(std::string("cmd -n '4")) < 0
+			  && args.last_error().code == ParseEvent::INPUT_ERROR
+			  && err.str().find("unterminated") != std::string::npos,
+			  "quoting error not reported");
+     }
+
+     return errors;
+}
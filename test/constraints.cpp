@@ -0,0 +1,124 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <deque>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//! Parse a command line, returning the error messages
+std::string parse(ProgramOptionManager& args,
+		  std::vector<const char*> argv,
+		  int& retval)
+{
+     std::ostringstream err;
+     args.set_error_stream(err);
+     args.reset();
+     argv.insert(argv.begin(), "constraints");
+     retval = args.process_arguments(static_cast<int>(argv.size()),
+				     const_cast<char**>(&argv[0]));
+     return err.str();
+}
+
+int main()
+{
+     int errors(0);
+     int retval(0);
+
+     bool a(false), b(false), c(false), d(false), e(false);
+     ProgramOptionManager args("constraints", "");
+     args.add_option("a", "alpha", a, "a flag");
+     args.add_option("b", "beta", b, "a flag");
+     args.add_option("c", "gamma", c, "a flag");
+     args.add_option("d", "delta", d, "a flag");
+     args.add_option("e", "epsilon", e, "a flag");
+     args.add_exclusive_group({"alpha", "beta"})
+	  .add_required_group({"a", "b", "c"})
+	  .add_requirement("gamma", {"delta"})
+	  .add_conflict("epsilon", {"delta", "alpha"});
+
+     // valid combinations
+     parse(args, {"-a"}, retval);
+     errors += check(retval > 0, "-a rejected");
+     parse(args, {"-b", "-c", "-d"}, retval);
+     errors += check(retval > 0, "-b -c -d rejected");
+     parse(args, {"-b", "-e"}, retval);
+     errors += check(retval > 0, "-b -e rejected");
+
+     std::string err(parse(args, {"-a", "-b"}, retval));
+     errors += check(retval < 0, "exclusive options accepted");
+     errors += check(err.find("--alpha and --beta cannot be used together")
+		     != std::string::npos,
+		     "wrong exclusion message");
+     errors += check(args.last_error().code == ParseEvent::CONSTRAINT_VIOLATED,
+		     "wrong error code");
+
+     err = parse(args, {"-d"}, retval);
+     errors += check(retval < 0, "missing group accepted");
+     errors += check(err.find("one of --alpha, --beta, --gamma is required")
+		     != std::string::npos,
+		     "wrong group message");
+
+     err = parse(args, {"-c"}, retval);
+     errors += check(retval < 0, "missing requirement accepted");
+     errors += check(err.find("--gamma requires --delta") != std::string::npos,
+		     "wrong requirement message");
+     errors += check(args.option(args.last_error().option) != NULL
+		     && args.option(args.last_error().option)->long_name()
+		     == "gamma",
+		     "wrong option for the requirement");
+
+     err = parse(args, {"-a", "-e"}, retval);
+     errors += check(retval < 0, "conflicting options accepted");
+     errors += check(err.find("--epsilon cannot be used with --alpha")
+		     != std::string::npos,
+		     "wrong conflict message");
+
+     // rules spanning several words of the set of options present
+     {
+	  const int n_options(300);
+	  std::vector<std::string> names;
+	  for (int i(0); i < n_options; ++i) {
+	       names.push_back("opt" + std::to_string(i));
+	  }
+	  std::deque<bool> flags(n_options, false);
+	  ProgramOptionManager many("constraints", "");
+	  for (int i(0); i < n_options; ++i) {
+	       many.add_option("", names[i].c_str(), flags[i], "a flag");
+	  }
+	  many.add_exclusive_group({"opt3", "opt150", "opt299"});
+	  many.add_requirement("opt70", {"opt10", "opt200"});
+
+	  parse(many, {"--opt3", "--opt70", "--opt10", "--opt200"}, retval);
+	  errors += check(retval > 0, "valid options rejected");
+	  err = parse(many, {"--opt150", "--opt299"}, retval);
+	  errors += check(retval < 0
+			  && err.find("--opt150 and --opt299") != std::string::npos,
+			  "exclusion across words not detected");
+	  err = parse(many, {"--opt70", "--opt10"}, retval);
+	  errors += check(retval < 0
+			  && err.find("--opt70 requires --opt200") != std::string::npos,
+			  "requirement across words not detected");
+     }
+
+     // unknown names are reported
+     {
+	  std::ostringstream out;
+	  args.set_error_stream(out);
+	  args.add_conflict("nothing", {"alpha"});
+	  errors += check(out.str().find("no option named nothing")
+			  != std::string::npos,
+			  "unknown option accepted");
+     }
+
+     return errors;
+}
@@ -0,0 +1,153 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <array>
+#include <deque>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+//! Vector recording the size it is reserved for
+struct RecordingVector : public std::vector<int>
+{
+     RecordingVector() : reserved(0) {}
+     void reserve(std::size_t n)
+	  {
+	       reserved = n;
+	       std::vector<int>::reserve(n);
+	  }
+     std::size_t reserved;
+};
+
+int main()
+{
+     int errors(0);
+
+     // values are inserted in the bound containers
+     {
+	  std::set<int> levels;
+	  std::unordered_set<std::string> tags;
+	  std::deque<double> weights;
+	  std::array<int, 3> origin = {{0, 0, 0}};
+	  SortedUniqueVector<int> ids;
+	  ProgramOptionManager args("containers", "");
+	  args.add_option("l", "level", levels, 1, "levels");
+	  args.add_option("t", "tag", tags, 1, "tags");
+	  args.add_option("w", "weights", weights, 2, "weights");
+	  args.add_option("o", "origin", origin, 3, "origin");
+	  args.add_option("ids", ids, 6, "identifiers");
+
+	  const char* argv[] = {"containers", "-l", "3", "-l", "1", "-l", "3",
+				"-t", "a", "--tag", "b", "-t", "a",
+				"-w", "0.5", "1.5", "-o", "1", "2", "3",
+				"5", "2", "9", "2", "7", "5", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(levels.size() == 2 && *levels.begin() == 1,
+			  "wrong levels");
+	  errors += check(tags.size() == 2 && tags.count("b") == 1,
+			  "wrong tags");
+	  errors += check(weights.size() == 2 && weights[1] == 1.5,
+			  "wrong weights");
+	  errors += check(origin[0] == 1 && origin[2] == 3, "wrong origin");
+	  const int sorted[] = {2, 5, 7, 9};
+	  errors += check(ids == std::vector<int>(sorted, sorted + 4),
+			  "identifiers not sorted and unique");
+     }
+
+     // arrays cannot take more values than their size
+     {
+	  std::array<int, 2> pair = {{0, 0}};
+	  std::ostringstream err;
+	  ProgramOptionManager args("containers", "");
+	  args.set_error_stream(err);
+	  args.add_option("p", "pair", pair, 3, "pair");
+	  const char* argv[] = {"containers", "-p", "1", "2", "3", NULL};
+	  errors += check(process(args, argv) < 0
+			  && args.last_error().code == ParseEvent::INVALID_VALUE,
+			  "array overflow accepted");
+     }
+
+     // containers are pre-sized before values are inserted
+     {
+	  RecordingVector values;
+	  RecordingVector rest;
+	  ProgramOptionManager args("containers", "");
+	  args.add_option("v", "values", values, 2, "values");
+	  args.add_option("rest", rest, 3, "other arguments");
+	  const char* argv[] = {"containers", "-v", "1", "2", "--values", "3", "4",
+				"5", "6", "7", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(values.reserved == 4 && values.size() == 4,
+			  "named vector not pre-sized");
+	  errors += check(rest.reserved == 3 && rest.size() == 3,
+			  "positional vector not pre-sized");
+     }
+     {
+	  RecordingVector values;
+	  ProgramOptionManager args("containers", "");
+	  args.add_option("v", "values", values, 1, "values");
+	  const char* argv[] = {"containers", "-v", "1", "-v", "2", NULL};
+	  char command[] = "";
+	  CommandLineSource source(command);
+	  errors += check(args.process_arguments(5, const_cast<char**>(argv),
+						 source) > 0,
+			  "parsing with a source failed");
+	  errors += check(values.reserved == 2 && values.size() == 2,
+			  "vector not pre-sized on the first call with a source");
+     }
+
+     // elements of any container are validated
+     {
+	  std::set<int> levels;
+	  std::ostringstream err;
+	  ProgramOptionManager args("containers", "");
+	  args.set_error_stream(err);
+	  args.add_option("l", "level", levels, 1, "levels");
+	  args.add_validator("level", in_range(0, 5));
+	  const char* argv[] = {"containers", "-l", "3", "-l", "8", NULL};
+	  errors += check(process(args, argv) < 0
+			  && args.last_error().code == ParseEvent::VALIDATION_FAILED,
+			  "invalid element accepted");
+     }
+
+     // containers are part of snapshots
+     {
+	  std::set<std::string> tags;
+	  std::array<int, 2> pair = {{0, 0}};
+	  SortedUniqueVector<int> ids;
+	  ProgramOptionManager args("containers", "");
+	  args.add_option("t", "tag", tags, 1, "tags");
+	  args.add_option("p", "pair", pair, 2, "pair");
+	  args.add_option("ids", ids, 3, "identifiers");
+	  const char* argv[] = {"containers", "-t", "b", "-t", "a", "-p", "4", "2",
+				"3", "1", "2", NULL};
+	  process(args, argv);
+
+	  std::vector<char> snapshot;
+	  errors += check(args.save_snapshot(snapshot), "snapshot failed");
+	  tags.clear();
+	  pair[0] = pair[1] = 0;
+	  ids.clear();
+	  args.reset();
+	  errors += check(args.restore_snapshot(&snapshot[0], snapshot.size()) > 0
+			  && tags.size() == 2 && *tags.begin() == "a"
+			  && pair[0] == 4 && pair[1] == 2
+			  && ids.size() == 3 && ids[0] == 1,
+			  "containers not restored");
+     }
+
+     return errors;
+}
@@ -0,0 +1,51 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+// only the declarations: options must come from program_options.cpp
+#include "program_options_decl.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef PROGRAM_OPTIONS_IMPL_HPP_INCLUDED
+#  error "program_options_impl.hpp included by program_options_decl.hpp"
+#endif
+
+int main()
+{
+     bool b(false);
+     int i(0);
+     unsigned int u(0);
+     double d(0.);
+     std::string name;
+     std::vector<double> point;
+     std::vector<int> values;
+
+     ProgramOptionManager args("prog", "");
+     args.add_option("b", "bool", b, "a boolean flag");
+     args.add_option("i", "int", i, "an integer");
+     args.add_option("u", "uint", "UNSIGNED", u, "an unsigned integer");
+     args.add_option("d", "double", d, "a double");
+     args.add_option("p", "point", point, 2, "a 2D point");
+     args.add_option("name", name, "a name");
+     args.add_option("values", values, 3, "three values");
+
+     const char* argv[] = {"prog", "-b", "-i", "7", "-u", "4", "-d", "0.5",
+			   "-p", "1", "2", "name", "1", "2", "3"};
+     const int retval(args.process_arguments(15, const_cast<char**>(argv)));
+
+     if (retval <= 0 || !b || i != 7 || u != 4 || d != 0.5
+	 || point.size() != 2 || point[1] != 2.
+	 || name != "name" || values.size() != 3 || values[2] != 3) {
+	  std::fprintf(stderr, "ERROR: wrong values\n");
+	  return 1;
+     }
+     return 0;
+}
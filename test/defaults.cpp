@@ -0,0 +1,160 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+bool consumed(const ProgramOptionManager& args, const std::string& name)
+{
+     for (int id(0); args.option(id) != NULL; ++id) {
+	  if (args.option(id)->long_name() == name) {
+	       return args.option(id)->consumed();
+	  }
+     }
+     return false;
+}
+
+//! Expensive default provider counting its calls
+struct Probe
+{
+     explicit Probe(int& calls_a) : calls(&calls_a) {}
+     unsigned int operator()() const
+	  {
+	       ++*calls;
+	       return 8;
+	  }
+     int* calls;
+};
+
+std::vector<int> zeros()
+{
+     return std::vector<int>(3, 0);
+}
+
+int main()
+{
+     int errors(0);
+
+     unsigned int threads(0);
+     std::vector<std::string> files;
+     int calls(0);
+
+     std::ostringstream err;
+     ProgramOptionManager args("defaults", "");
+     args.set_error_stream(err);
+     args.add_option("j", "threads", threads, "number of threads");
+     args.add_option("files", files, anything_but_last(), "input files", false);
+     args.set_default("threads",
+		      default_from<unsigned int>(Probe(calls), "CPU count"));
+
+     // help does not evaluate the default but shows its description
+     {
+	  const char* argv[] = {"defaults", "-h", NULL};
+	  std::streambuf* buf(std::cout.rdbuf(NULL));
+	  process(args, argv);
+	  std::cout.rdbuf(buf);
+	  errors += check(calls == 0, "default evaluated for help");
+	  errors += check(args.help_text().find("(default: CPU count)")
+			  != std::string::npos,
+			  "default missing from help");
+	  args.reset();
+     }
+
+     // not evaluated when the option is present
+     {
+	  const char* argv[] = {"defaults", "-j", "2", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(calls == 0 && threads == 2, "default used while present");
+	  errors += check(consumed(args, "threads"), "option not consumed");
+	  args.reset();
+     }
+
+     // evaluated once when absent, the value is assigned again afterwards
+     for (int i(0); i < 2; ++i) {
+	  threads = 0;
+	  const char* argv[] = {"defaults", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(threads == 8, "default not assigned");
+	  errors += check(calls == 1, "default evaluated more than once");
+	  errors += check(!consumed(args, "threads"),
+			  "defaulted option marked as consumed");
+	  args.reset();
+     }
+
+     // not evaluated when parsing fails
+     {
+	  int failed_calls(0);
+	  unsigned int count(0);
+	  ProgramOptionManager other("defaults", "");
+	  other.set_error_stream(err);
+	  other.add_option("c", "count", count, "a count");
+	  other.set_default("c", default_from<unsigned int>(Probe(failed_calls),
+							    "8"));
+	  const char* argv[] = {"defaults", "--unknown", NULL};
+	  errors += check(process(other, argv) < 0,
+			  "unknown option accepted");
+	  errors += check(failed_calls == 0, "default evaluated on error");
+     }
+
+     // containers are filled with the default when absent
+     {
+	  std::vector<int> v;
+	  ProgramOptionManager other("defaults", "");
+	  other.add_option("v", "vector", v, 3, "three values");
+	  other.set_default("vector",
+			    default_from<std::vector<int> >(zeros, "0 0 0"));
+	  const char* argv[] = {"defaults", NULL};
+	  errors += check(process(other, argv) > 0,
+			  "parsing failed");
+	  errors += check(v == std::vector<int>(3, 0),
+			  "default container not assigned");
+     }
+
+     // optional positional containers take the default without values
+     {
+	  std::vector<int> v;
+	  std::string last;
+	  ProgramOptionManager other("defaults", "");
+	  other.add_option("values", v, anything_but_last(), "values", false);
+	  other.add_option("last", last, "last value", false);
+	  other.set_default("values",
+			    default_from<std::vector<int> >(zeros, "0 0 0"));
+	  const char* none[] = {"defaults", NULL};
+	  errors += check(process(other, none) > 0, "parsing failed");
+	  errors += check(v == std::vector<int>(3, 0),
+			  "default positional container not assigned");
+
+	  other.reset();
+	  v.clear();
+	  const char* argv[] = {"defaults", "1", "2", NULL};
+	  errors += check(process(other, argv) > 0 && v.size() == 1
+			  && v[0] == 1 && last == "2",
+			  "default assigned to a positional container with values");
+     }
+
+     // mismatching types and unknown names are rejected
+     {
+	  err.str("");
+	  args.set_default("threads", default_from<int>(Probe(calls), "8"));
+	  args.set_default("nothing", default_from<unsigned int>(Probe(calls), "8"));
+	  errors += check(err.str().find("does not match") != std::string::npos,
+			  "mismatching default type accepted");
+	  errors += check(err.str().find("no option named nothing")
+			  != std::string::npos,
+			  "default for unknown option accepted");
+     }
+
+     return errors;
+}
@@ -0,0 +1,69 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+
+#include <string>
+#include <vector>
+
+int main()
+{
+     bool version(false);
+     unsigned int n(0);
+     std::vector<int> v;
+     std::vector<std::string> files;
+
+     ProgramOptionManager args("prog", "");
+     args.add_option("files", files, 2, "input files");
+     args.add_option("V", "version", version, "print version and exit");
+     args.add_option("n", "number", n, "a number");
+     args.add_option("v", "vector", v, 2, "two values");
+
+     const char* argv[] = {"prog", "-n3", "a.cpp", "-v", "1", "2",
+			   "--unknown", "--version", "b.cpp", "c.cpp"};
+     const int argc(10);
+
+     const ParseEvent::TYPE expected[] = {
+	  ParseEvent::OPTION_MATCHED,
+	  ParseEvent::VALUE_CONVERTED,
+	  ParseEvent::POSITIONAL_VALUE,
+	  ParseEvent::OPTION_MATCHED,
+	  ParseEvent::VALUE_CONVERTED,
+	  ParseEvent::VALUE_CONVERTED,
+	  ParseEvent::PARSE_ERROR,
+	  ParseEvent::OPTION_MATCHED
+     };
+     const int tokens[] = {1, 1, 2, 3, 4, 5, 6, 7};
+
+     ParseEventStream stream(args, argc, const_cast<char**>(argv));
+     unsigned int i(0);
+     for (ParseEventStream::iterator it(stream.begin());
+	  it != stream.end();
+	  ++it, ++i) {
+	  if (i == 8 || it->type != expected[i] || it->token != tokens[i]) {
+	       std::cerr << "ERROR: unexpected event #" << i << std::endl;
+	       return -1;
+	  }
+	  if (it->type == ParseEvent::PARSE_ERROR
+	      && (it->error != ParseEvent::UNKNOWN_OPTION
+		  || stream.argument() != "--unknown")) {
+	       std::cerr << "ERROR: unexpected error event\n";
+	       return -1;
+	  }
+	  if (version) {
+	       break; // stop early, the remaining arguments are never looked at
+	  }
+     }
+
+     if (!version || n != 3 || v.size() != 2 || files.size() != 1) {
+	  std::cerr << "ERROR: wrong values after partial parsing\n";
+	  return -1;
+     }
+     return 0;
+}
@@ -0,0 +1,271 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+/*
+ * Fuzzing target for hardened parsing (see ParseLimits). Built with
+ * -DPROGRAM_OPTIONS_FUZZ=ON (clang), this is a libFuzzer target reading
+ * NUL-separated arguments; otherwise main() runs crafted and pseudo-random
+ * inputs through the same checks.
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+     //! Argument source recording how much of the input the parser read
+     class CountingSource : public ArgumentSource
+     {
+     public:
+	  explicit CountingSource(const std::vector<std::string>& args)
+	       : args_(args)
+	       , read_(0)
+	       , bytes_(0)
+	       {}
+
+	  bool next(std::string& arg)
+	       {
+		    if (read_ == args_.size()) {
+			 return false;
+		    }
+		    arg = args_[read_++];
+		    bytes_ += arg.size();
+		    return true;
+	       }
+
+	  std::size_t read() const { return read_; }
+	  std::size_t bytes() const { return bytes_; }
+
+     private:
+	  const std::vector<std::string>& args_;
+	  std::size_t read_;
+	  std::size_t bytes_;
+     };
+
+     ParseLimits fuzz_limits()
+     {
+	  ParseLimits limits;
+	  limits.max_arguments = 64;
+	  limits.max_argument_size = 256;
+	  limits.max_total_size = 4096;
+	  limits.max_occurrences = 8;
+	  limits.max_file_arguments = 1;
+	  return limits;
+     }
+}
+
+//! Parse NUL-separated arguments under limits
+/** \return False if the parser read more than the limits allow or accepted
+ *          an input beyond them
+ */
+bool bounds_hold(const std::uint8_t* data, std::size_t size)
+{
+     const ParseLimits limits(fuzz_limits());
+     std::vector<std::string> input(1);
+     for (std::size_t i(0); i < size; ++i) {
+	  if (data[i] == '\0') {
+	       input.push_back(std::string());
+	  }
+	  else {
+	       input.back() += static_cast<char>(data[i]);
+	  }
+     }
+
+     int a(0);
+     bool f(false);
+     std::string s, last;
+     std::vector<int> v;
+     std::vector<std::string> rest;
+
+     std::ostringstream err;
+     ProgramOptionManager args("fuzz", "");
+     args.set_error_stream(err);
+     args.set_parse_limits(limits);
+     args.add_option("a", "alpha", a, "a number");
+     args.add_option("f", "flag", f, "a flag");
+     args.add_option("s", "string", s, "a string");
+     args.add_option("v", "values", v, 2, "two numbers per occurrence");
+     args.add_option("rest", rest, anything_but_last(), "other arguments");
+     args.add_option("last", last, "last argument");
+
+     CountingSource source(input);
+     char prog[] = "fuzz";
+     char* argv[] = {prog, NULL};
+     const int retval(args.process_arguments(1, argv, source));
+
+     // fail fast: at most one argument read beyond the limits
+     const std::size_t last_size(source.read() == 0
+				 ? 0 : input[source.read() - 1].size());
+     if (source.read() > limits.max_arguments + 1
+	 || source.bytes() - last_size > limits.max_total_size) {
+	  return false;
+     }
+
+     // an input accepted is within the limits
+     if (retval >= 0) {
+	  std::size_t total(0);
+	  for (std::size_t i(0); i < input.size(); ++i) {
+	       if (input[i].size() > limits.max_argument_size) {
+		    return false;
+	       }
+	       total += input[i].size();
+	  }
+	  if (input.size() > limits.max_arguments
+	      || total > limits.max_total_size
+	      || v.size() > 2 * limits.max_occurrences) {
+	       return false;
+	  }
+     }
+     // errors are recorded
+     return retval >= 0 || args.last_error().code != ParseEvent::NONE;
+}
+
+#ifdef PROGRAM_OPTIONS_FUZZER
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+     if (!bounds_hold(data, size)) {
+	  std::abort();
+     }
+     return 0;
+}
+#else
+bool bounds_hold(const std::string& input)
+{
+     return bounds_hold(reinterpret_cast<const std::uint8_t*>(input.data()),
+			input.size());
+}
+
+//! Parse with the fuzzing limits, return the error code
+ParseEvent::ERROR_CODE parse(const std::vector<std::string>& input)
+{
+     std::ostringstream err;
+     bool f(false);
+     std::string s, last;
+     std::vector<int> v;
+     std::vector<std::string> rest;
+     ProgramOptionManager args("fuzz", "");
+     args.set_error_stream(err);
+     args.set_parse_limits(fuzz_limits());
+     args.add_option("f", "flag", f, "a flag");
+     args.add_option("s", "string", s, "a string");
+     args.add_option("v", "values", v, 2, "two numbers per occurrence");
+     args.add_option("rest", rest, anything_but_last(), "other arguments");
+     args.add_option("last", last, "last argument");
+
+     std::vector<char*> argv(1, const_cast<char*>("fuzz"));
+     for (std::size_t i(0); i < input.size(); ++i) {
+	  argv.push_back(const_cast<char*>(input[i].c_str()));
+     }
+     argv.push_back(NULL);
+     args.process_arguments(static_cast<int>(argv.size() - 1), &argv[0]);
+     return args.last_error().code;
+}
+
+int main()
+{
+     int errors(0);
+
+     // each limit
+     {
+	  errors += check(parse(std::vector<std::string>(64, "x")) == ParseEvent::NONE,
+			  "arguments within the limit rejected");
+	  errors += check(parse(std::vector<std::string>(65, "x"))
+			  == ParseEvent::LIMIT_EXCEEDED,
+			  "too many arguments accepted");
+	  errors += check(parse(std::vector<std::string>(1, std::string(257, 'x')))
+			  == ParseEvent::LIMIT_EXCEEDED,
+			  "argument too long accepted");
+	  errors += check(parse(std::vector<std::string>(20, std::string(250, 'x')))
+			  == ParseEvent::LIMIT_EXCEEDED,
+			  "too many bytes accepted");
+
+	  std::vector<std::string> repeated;
+	  for (int i(0); i < 9; ++i) {
+	       repeated.push_back(i % 2 == 0 ? "-v" : "--values");
+	       repeated.push_back("1");
+	       repeated.push_back("2");
+	  }
+	  errors += check(parse(repeated) == ParseEvent::LIMIT_EXCEEDED,
+			  "too many occurrences accepted");
+	  repeated.resize(8 * 3);
+	  repeated.push_back("x");
+	  errors += check(parse(repeated) == ParseEvent::NONE,
+			  "occurrences within the limit rejected");
+
+	  std::vector<std::string> files(2, "@file:/etc/passwd");
+	  errors += check(parse(files) == ParseEvent::LIMIT_EXCEEDED,
+			  "too many file arguments accepted");
+	  files[0] = "-s@file:/etc/passwd";
+	  files[1] = "-s@file:/etc/passwd";
+	  errors += check(parse(files) == ParseEvent::LIMIT_EXCEEDED,
+			  "too many attached file arguments accepted");
+     }
+
+     // limits are opt-in
+     {
+	  std::string last;
+	  std::vector<std::string> rest;
+	  ProgramOptionManager args("fuzz", "");
+	  args.add_option("rest", rest, anything_but_last(), "other arguments");
+	  args.add_option("last", last, "last argument");
+	  std::vector<char*> argv(1001, const_cast<char*>("x"));
+	  argv.push_back(NULL);
+	  errors += check(args.process_arguments(1001, &argv[0]) > 0
+			  && rest.size() == 999,
+			  "arguments limited without limits set");
+     }
+
+     // crafted inputs fail after reading a bounded part of them
+     {
+	  std::string flags;
+	  for (int i(0); i < 100000; ++i) {
+	       flags += std::string("-f", 3);
+	  }
+	  errors += check(bounds_hold(flags), "repeated flags");
+	  errors += check(bounds_hold(std::string(1 << 20, 'x')), "huge argument");
+	  errors += check(bounds_hold(std::string(100000, '\0')), "empty arguments");
+	  errors += check(bounds_hold(std::string()), "empty input");
+     }
+
+     // pseudo-random inputs built from tokens
+     {
+	  const char* tokens[] = {"-a", "--alpha", "-f", "--flag", "-s", "-v",
+				  "--values", "1", "-2", "x", "--", "-a7",
+				  "@file:/dev/null", "-v@file:/dev/null",
+				  "--unknown", ""};
+	  const std::size_t n_tokens(sizeof(tokens) / sizeof(tokens[0]));
+	  std::uint32_t state(2463534242U);
+	  for (int run(0); run < 2000; ++run) {
+	       std::string input;
+	       state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+	       const std::size_t n_args(state % 100);
+	       for (std::size_t i(0); i < n_args; ++i) {
+		    state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+		    if (i > 0) {
+			 input += '\0';
+		    }
+		    input += (state % 64 == 0
+			      ? std::string(state % 512, 'y')
+			      : std::string(tokens[state % n_tokens]));
+	       }
+	       if (!bounds_hold(input)) {
+		    errors += check(false, "bounds broken by a random input");
+		    break;
+	       }
+	  }
+     }
+
+     return errors;
+}
+#endif /* PROGRAM_OPTIONS_FUZZER */
@@ -0,0 +1,100 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+std::string not_empty(const InternedString& value)
+{
+     return value.empty() ? "empty label" : "";
+}
+
+int main()
+{
+     int errors(0);
+
+     // repeated values share their storage
+     {
+	  InternedStrings labels;
+	  std::string last;
+	  ProgramOptionManager args("interning", "");
+	  args.add_option("labels", labels, anything_but_last(), "labels");
+	  args.add_option("last", last, "last argument");
+
+	  const char* argv[] = {"interning", "cat", "dog", "cat", "cat", "dog",
+				"end", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(labels.size() == 5 && labels.pool().size() == 2,
+			  "labels not interned");
+	  errors += check(labels[0] == labels[2] && labels[0] != labels[1]
+			  && labels[4].str() == "dog"
+			  && labels[1].c_str() == labels[4].c_str(),
+			  "wrong handles");
+	  errors += check(labels[0] < labels[1] && !(labels[1] < labels[0]),
+			  "wrong order");
+	  std::unordered_set<InternedString> distinct(labels.begin(),
+						      labels.end());
+	  errors += check(distinct.size() == 2, "wrong hash");
+     }
+
+     // options may share a pool (and compare their handles)
+     {
+	  std::shared_ptr<InternPool> pool(std::make_shared<InternPool>());
+	  InternedStrings hosts(pool);
+	  InternedStrings shards(pool);
+	  ProgramOptionManager args("interning", "");
+	  args.add_option("H", "host", hosts, 1, "hosts");
+	  args.add_option("s", "shard", shards, 2, "shards");
+	  args.add_validator("host", check_with<InternedString>(not_empty));
+
+	  const char* argv[] = {"interning", "-H", "a", "-s", "b", "a", "-Hb",
+				NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(pool->size() == 2 && hosts[0] == shards[1]
+			  && hosts[1] == shards[0],
+			  "pool not shared");
+
+	  std::vector<char> snapshot;
+	  errors += check(args.save_snapshot(snapshot), "snapshot failed");
+	  hosts.clear();
+	  args.reset();
+	  errors += check(args.restore_snapshot(&snapshot[0], snapshot.size()) > 0
+			  && hosts.size() == 2 && hosts[0] == shards[1],
+			  "interned strings not restored");
+     }
+
+     // the pool grows beyond its first block and table
+     {
+	  InternPool pool;
+	  std::vector<InternedString> handles;
+	  for (int i(0); i < 10000; ++i) {
+	       handles.push_back(pool.intern("value " + std::to_string(i)));
+	  }
+	  const std::string big(100000, 'x');
+	  const InternedString big_handle(pool.intern(big));
+	  bool same(big_handle == pool.intern(big) && big_handle.str() == big);
+	  for (int i(0); i < 10000; ++i) {
+	       same = same
+		    && handles[i] == pool.intern("value " + std::to_string(i));
+	  }
+	  errors += check(same && pool.size() == 10001, "wrong pool lookups");
+	  errors += check(pool.intern("") == InternedString(),
+			  "empty string not interned as default handle");
+     }
+
+     return errors;
+}
@@ -0,0 +1,110 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! Map recording the size it is reserved for
+struct RecordingMap : public std::map<std::string, std::string>
+{
+     RecordingMap() : reserved(0) {}
+     void reserve(std::size_t n) { reserved = n; }
+     std::size_t reserved;
+};
+
+int main()
+{
+     int errors(0);
+
+     // last value wins, values may contain '='
+     {
+	  std::unordered_map<std::string, std::string> defines;
+	  std::map<std::string, int> levels;
+	  ProgramOptionManager args("maps", "");
+	  args.add_option("D", "define", defines, LAST_WINS, "macro definitions");
+	  args.add_option("l", "level", levels, UNIQUE_KEYS, "levels per module");
+
+	  const char* argv[] = {"maps", "-DNDEBUG=1", "-D", "EXPR=a=b",
+				"--define", "NDEBUG=0", "-l", "io=3",
+				"-lnet=4", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(defines.size() == 2
+			  && defines["NDEBUG"] == "0"
+			  && defines["EXPR"] == "a=b",
+			  "wrong definitions");
+	  errors += check(levels.size() == 2
+			  && levels["io"] == 3 && levels["net"] == 4,
+			  "wrong levels");
+     }
+
+     // containers with reserve() are pre-sized from the number of occurrences
+     {
+	  RecordingMap defines;
+	  std::vector<std::string> rest;
+	  ProgramOptionManager args("maps", "");
+	  args.add_option("D", "define", defines, LAST_WINS, "macro definitions");
+	  args.add_option("rest", rest, 2, "other arguments");
+	  const char* argv[] = {"maps", "-DA=1", "-D", "B=2", "--define", "C=3",
+				"--", "-DD=4", "x", NULL};
+	  errors += check(process(args, argv) > 0
+			  && rest.size() == 2,
+			  "parsing failed");
+	  errors += check(defines.reserved == 3, "map not pre-sized");
+     }
+
+     // repeated keys and malformed arguments are invalid values
+     {
+	  std::map<std::string, int> levels;
+	  std::ostringstream err;
+	  ProgramOptionManager args("maps", "");
+	  args.set_error_stream(err);
+	  args.add_option("l", "level", levels, UNIQUE_KEYS, "levels per module");
+
+	  const char* repeated[] = {"maps", "-l", "io=3", "-l", "io=4", NULL};
+	  errors += check(process(args, repeated) < 0
+			  && args.last_error().code == ParseEvent::INVALID_VALUE,
+			  "repeated key accepted");
+
+	  const char* malformed[] = {"maps", "-l", "io", NULL};
+	  args.reset();
+	  errors += check(process(args, malformed) < 0,
+			  "argument without '=' accepted");
+
+	  const char* not_int[] = {"maps", "-l", "io=x", NULL};
+	  args.reset();
+	  errors += check(process(args, not_int) < 0,
+			  "invalid value accepted");
+     }
+
+     // maps are part of snapshots
+     {
+	  std::map<std::string, int> levels;
+	  ProgramOptionManager args("maps", "");
+	  args.add_option("l", "level", levels, LAST_WINS, "levels per module");
+	  const char* argv[] = {"maps", "-l", "io=3", "-l", "net=4", NULL};
+	  process(args, argv);
+
+	  std::vector<char> snapshot;
+	  errors += check(args.save_snapshot(snapshot), "snapshot failed");
+	  levels.clear();
+	  args.reset();
+	  errors += check(args.restore_snapshot(&snapshot[0], snapshot.size()) > 0
+			  && levels.size() == 2 && levels["net"] == 4,
+			  "map not restored");
+     }
+
+     return errors;
+}
@@ -0,0 +1,113 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <cstdio>
+#include <deque>
+#include <sstream>
+#include <string>
+#include <vector>
+
+void write_file(const char* filename, const void* data, std::size_t size)
+{
+     std::FILE* out(std::fopen(filename, "wb"));
+     std::fwrite(data, 1, size, out);
+     std::fclose(out);
+}
+
+int main()
+{
+     int errors(0);
+     const char* binary("mapped_values_test.bin");
+     const char* text("mapped_values_test.txt");
+
+     std::vector<double> weights(100000);
+     for (std::size_t i(0); i < weights.size(); ++i) {
+	  weights[i] = 0.5 * i;
+     }
+     write_file(binary, &weights[0], weights.size() * sizeof(double));
+     const char values[] = "1,2\n3 4\r\n\n5";
+     write_file(text, values, sizeof(values) - 1);
+
+     // binary files are mapped, text files are converted
+     {
+	  MappedArray<double> mapped;
+	  std::vector<int> ids;
+	  std::deque<unsigned int> rest;
+	  std::vector<std::string> names;
+	  ProgramOptionManager args("mapped", "");
+	  args.add_option("w", "weights", mapped, "weights");
+	  args.add_option("i", "ids", ids, 1, "identifiers");
+	  args.add_option("n", "name", names, 1, "names");
+	  args.add_option("rest", rest, 2, "other values");
+
+	  const std::string binary_arg(std::string("@file:") + binary);
+	  const std::string text_arg(std::string("@file:") + text);
+	  const char* argv[] = {"mapped", "--weights", binary_arg.c_str(),
+				"-i", "0", "-i", text_arg.c_str(),
+				"-n", text_arg.c_str(), "7", text_arg.c_str(),
+				NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(mapped.size() == weights.size()
+			  && mapped[0] == 0 && mapped[99999] == 0.5 * 99999,
+			  "wrong mapped values");
+	  const int expected_ids[] = {0, 1, 2, 3, 4, 5};
+	  errors += check(ids == std::vector<int>(expected_ids, expected_ids + 6),
+			  "wrong values read from text file");
+	  errors += check(rest.size() == 6 && rest[0] == 7 && rest[5] == 5,
+			  "wrong positional values read from text file");
+	  errors += check(names.size() == 1 && names[0] == text_arg,
+			  "string values read from file");
+
+	  // copies share the mapping
+	  MappedArray<double> copy(mapped);
+	  errors += check(copy.data() == mapped.data(), "mapping copied");
+     }
+
+     // unreadable files and files of the wrong size are invalid values
+     {
+	  MappedArray<std::int64_t> mapped;
+	  std::vector<int> ids;
+	  std::ostringstream err;
+	  ProgramOptionManager args("mapped", "");
+	  args.set_error_stream(err);
+	  args.add_option("w", "weights", mapped, "weights");
+	  args.add_option("i", "ids", ids, 1, "identifiers");
+
+	  const char one_byte[] = "x";
+	  write_file(text, one_byte, 1);
+	  const std::string arg(std::string("@file:") + text);
+	  const char* odd_size[] = {"mapped", "-w", arg.c_str(), NULL};
+	  errors += check(process(args, odd_size) < 0
+			  && args.last_error().code == ParseEvent::INVALID_VALUE,
+			  "file of the wrong size mapped");
+
+	  const char* no_prefix[] = {"mapped", "-w", binary, NULL};
+	  args.reset();
+	  errors += check(process(args, no_prefix) < 0,
+			  "argument without @file: accepted");
+
+	  const char* missing[] = {"mapped", "-i", "@file:does/not/exist", NULL};
+	  args.reset();
+	  errors += check(process(args, missing) < 0,
+			  "missing file accepted");
+
+	  const char* not_int[] = {"mapped", "-i", arg.c_str(), NULL};
+	  args.reset();
+	  errors += check(process(args, not_int) < 0,
+			  "invalid value in file accepted");
+     }
+
+     std::remove(binary);
+     std::remove(text);
+     return errors;
+}
@@ -0,0 +1,121 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if defined(_GLIBCXX_IOSTREAM) || defined(_LIBCPP_IOSTREAM)
+#  error "<iostream> included with PROGRAM_OPTIONS_NO_IOSTREAM"
+#endif
+
+struct Values
+{
+     Values() : b(false), u(0), d(0.), c(' ') {}
+
+     bool b;
+     unsigned int u;
+     double d;
+     char c;
+     std::string name;
+     std::vector<int> values;
+};
+
+int parse(Values& v, ProgramOptionManager& args, int argc, const char** argv)
+{
+     args.add_option("b", "bool", v.b, "a boolean flag");
+     args.add_option("u", "uint", v.u, "an unsigned integer");
+     args.add_option("d", "double", v.d, "a double");
+     args.add_option("c", "char", v.c, "a character");
+     args.add_option("name", v.name, "a name");
+     args.add_option("values", v.values, 2, "two values", false);
+     return args.process_arguments(argc, const_cast<char**>(argv));
+}
+
+int main()
+{
+     int errors(0);
+
+     {
+	  Values v;
+	  ProgramOptionManager args("prog", "");
+	  const char* argv[] = {"prog", "-b", "-u", "42", "-d", "2.5",
+				"-c", "x", "some name", "3", "7"};
+	  errors += check(parse(v, args, 11, argv) > 0, "parsing failed");
+	  errors += check(v.b && v.u == 42 && v.d == 2.5 && v.c == 'x'
+			  && v.name == "some name"
+			  && v.values.size() == 2
+			  && v.values[0] == 3 && v.values[1] == 7,
+			  "wrong values");
+	  errors += check(args.last_error().code == ParseEvent::NONE,
+			  "error reported on success");
+     }
+
+     // invalid and out of range values
+     const char* invalid[][3] = {{"prog", "-u", "4x"},
+				 {"prog", "-u", "99999999999"},
+				 {"prog", "-d", "abc"},
+				 {"prog", "-c", "xy"}};
+     for (int i(0); i < 4; ++i) {
+	  Values v;
+	  ProgramOptionManager args("prog", "");
+	  errors += check(parse(v, args, 3, invalid[i]) < 0,
+			  "invalid value accepted");
+	  const ParseError& error(args.last_error());
+	  errors += check(error.code == ParseEvent::INVALID_VALUE
+			  && error.token == 2
+			  && args.option(error.option) != NULL
+			  && args.option(error.option)->short_name()
+			  == std::string(invalid[i][1] + 1),
+			  "wrong structured error for an invalid value");
+     }
+
+     // unknown option
+     {
+	  Values v;
+	  ProgramOptionManager args("prog", "");
+	  const char* argv[] = {"prog", "name", "--unknown"};
+	  errors += check(parse(v, args, 3, argv) < 0, "unknown option accepted");
+	  errors += check(args.last_error().code == ParseEvent::UNKNOWN_OPTION
+			  && args.last_error().token == 2
+			  && args.last_error().option == -1,
+			  "wrong structured error for an unknown option");
+     }
+
+     // missing required positional
+     {
+	  Values v;
+	  ProgramOptionManager args("prog", "");
+	  const char* argv[] = {"prog", "-b"};
+	  errors += check(parse(v, args, 2, argv) < 0, "missing value accepted");
+	  const ParseError& error(args.last_error());
+	  errors += check(error.code == ParseEvent::MISSING_REQUIRED
+			  && error.token == -1
+			  && args.option(error.option) != NULL
+			  && args.option(error.option)->help_name() == "name",
+			  "wrong structured error for a missing option");
+     }
+
+     // help is not printed but can be rendered by the caller
+     {
+	  Values v;
+	  ProgramOptionManager args("prog", "");
+	  const char* argv[] = {"prog", "-h"};
+	  errors += check(parse(v, args, 2, argv) == 0, "help not requested");
+	  const std::string help(args.help_text());
+	  errors += check(help.find("usage: prog name values") == 0
+			  && help.find("-u [ --uint ] UINT") != std::string::npos,
+			  "wrong help text");
+     }
+
+     return errors;
+}
@@ -0,0 +1,122 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct config
+{
+     config() : timeout(0), priority(1), fast(false), safe(false) {}
+
+     unsigned int timeout;
+     int priority;
+     bool fast;
+     bool safe;
+     std::vector<std::string> files;
+     std::string input;
+};
+
+void bind(ProgramOptionManager& args, config& cfg)
+{
+     args.add_option("t", "timeout", cfg.timeout, "timeout");
+     args.add_option("p", "priority", cfg.priority, "priority");
+     args.add_option("F", "fast", cfg.fast, "fast mode");
+     args.add_option("S", "safe", cfg.safe, "safe mode");
+     args.add_option("f", "file", cfg.files, 1, "a file");
+     args.add_option("input", cfg.input, "input");
+     args.add_validator("priority", in_range(0, 10));
+     args.add_conflict("fast", {"safe"});
+}
+
+template <std::size_t N>
+int process_overlay(ProgramOptionManager& args, const char* (&argv)[N])
+{
+     return args.process_overlay(static_cast<int>(N - 1),
+				 const_cast<char**>(argv));
+}
+
+int main()
+{
+     int errors(0);
+
+     config cfg;
+     std::ostringstream err;
+     ProgramOptionManager args("overlay", "");
+     args.set_error_stream(err);
+     bind(args, cfg);
+
+     const char* base[] = {"overlay", "-t", "10", "-S", "-f", "a", "-f", "b",
+			   "in", NULL};
+     errors += check(process(args, base) > 0,
+		     "base parsing failed");
+     args.set_overlay_base();
+
+     // overridden options only
+     {
+	  const char* argv[] = {"overlay", "--timeout", "5", NULL};
+	  errors += check(process_overlay(args, argv) > 0, "overlay failed");
+	  errors += check(cfg.timeout == 5 && cfg.priority == 1 && cfg.safe
+			  && cfg.files.size() == 2 && cfg.input == "in",
+			  "wrong values with an overlay");
+     }
+
+     // each overlay applies to the base
+     {
+	  const char* argv[] = {"overlay", "-p", "3", "-f", "c", NULL};
+	  errors += check(process_overlay(args, argv) > 0, "overlay failed");
+	  errors += check(cfg.timeout == 10 && cfg.priority == 3
+			  && cfg.files.size() == 1 && cfg.files[0] == "c",
+			  "previous overlay not undone");
+
+	  args.clear_overlay();
+	  errors += check(cfg.priority == 1 && cfg.files.size() == 2
+			  && cfg.files[1] == "b",
+			  "base values not restored");
+     }
+
+     // errors restore the base
+     {
+	  const char* positional[] = {"overlay", "-t", "7", "other", NULL};
+	  errors += check(process_overlay(args, positional) < 0
+			  && args.last_error().code == ParseEvent::UNEXPECTED_ARGUMENT
+			  && cfg.timeout == 10,
+			  "positional value overridden");
+
+	  const char* conflict[] = {"overlay", "-t", "7", "--fast", NULL};
+	  errors += check(process_overlay(args, conflict) < 0
+			  && args.last_error().code == ParseEvent::CONSTRAINT_VIOLATED
+			  && !cfg.fast && cfg.timeout == 10,
+			  "constraint of an overridden option not checked");
+
+	  const char* invalid[] = {"overlay", "-p", "11", NULL};
+	  errors += check(process_overlay(args, invalid) < 0
+			  && args.last_error().code == ParseEvent::VALIDATION_FAILED
+			  && cfg.priority == 1,
+			  "validator of an overridden option not run");
+
+	  const char* duplicate[] = {"overlay", "-t", "1", "-t", "2", NULL};
+	  errors += check(process_overlay(args, duplicate) < 0
+			  && args.last_error().code == ParseEvent::DUPLICATE_OPTION
+			  && cfg.timeout == 10,
+			  "option repeated in an overlay");
+     }
+
+     // constraints see the base state again once an overlay is undone
+     {
+	  const char* argv[] = {"overlay", "--safe", NULL};
+	  errors += check(process_overlay(args, argv) > 0 && cfg.safe,
+			  "overriding an option of the base failed");
+     }
+
+     return errors;
+}
@@ -0,0 +1,111 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+
+#include <string>
+#include <vector>
+
+std::vector<int> zero()
+{
+     return std::vector<int>(1, 0);
+}
+
+struct values {
+     values() : b(false), u(7) {}
+
+     bool b;
+     unsigned int u;
+     std::vector<int> v;
+     std::vector<std::string> files;
+     std::string output;
+};
+
+int parse(ProgramOptionManager& args, const char* cmd[], int argc,
+	  bool b, unsigned int u, std::size_t n_files,
+	  const values& val)
+{
+     if (args.process_arguments(argc, const_cast<char**>(cmd)) <= 0) {
+	  return -1;
+     }
+     if (val.b != b || val.u != u || val.files.size() != n_files
+	 || val.output != cmd[argc-1]) {
+	  std::cerr << "ERROR: wrong values after parsing " << cmd[1] << std::endl;
+	  return -1;
+     }
+     return 0;
+}
+
+int main()
+{
+     values val;
+     ProgramOptionManager args("prog", "");
+     args.add_option("files", val.files, anything_but_last(), "some files");
+     args.add_option("output", val.output, "output file");
+     args.add_option("b", "bool", val.b, "a boolean flag");
+     args.add_option("u", "uint", val.u, "a number");
+     args.add_option("v", "vector", val.v, 2, "two values");
+
+     if (!args.enable_parse_cache(2)) {
+	  return -1;
+     }
+
+     const char* first[] = {"prog", "-b", "-u", "1", "a.cpp", "b.cpp", "out"};
+     const char* second[] = {"prog", "-u", "2", "-v", "1", "2", "a.cpp", "out"};
+     const char* third[] = {"prog", "out"};
+     // same arguments as first, but split differently
+     const char* first_bis[] = {"prog", "-b", "-u", "1", "a.cppb.cpp", "out"};
+
+     for (unsigned int i(0); i < 100; ++i) {
+	  if (parse(args, first, 7, true, 1, 2, val) != 0
+	      || parse(args, second, 8, false, 2, 1, val) != 0
+	      || val.v.size() != 2) {
+	       return -1;
+	  }
+     }
+     if (args.parse_cache_misses() != 2 || args.parse_cache_hits() != 198) {
+	  std::cerr << "ERROR: unexpected cache statistics\n";
+	  return -1;
+     }
+
+     // evicts first
+     if (parse(args, third, 2, false, 7, 0, val) != 0
+	 || !val.v.empty()
+	 || parse(args, first, 7, true, 1, 2, val) != 0
+	 || parse(args, first_bis, 6, true, 1, 1, val) != 0
+	 || args.parse_cache_misses() != 5) {
+	  std::cerr << "ERROR: LRU eviction or verification failed\n";
+	  return -1;
+     }
+
+     // targets assigned a default are reset before the next call
+     std::vector<int> v;
+     ProgramOptionManager other("prog", "");
+     other.add_option("v", "vector", v, 1, "values");
+     other.set_default("vector", default_from<std::vector<int> >(zero, "0"));
+     if (!other.enable_parse_cache(4)) {
+	  return -1;
+     }
+     const char* none[] = {"prog", NULL};
+     const char* one[] = {"prog", "-v", "1", NULL};
+     for (unsigned int i(0); i < 2; ++i) {
+	  if (other.process_arguments(1, const_cast<char**>(none)) <= 0
+	      || v != std::vector<int>(1, 0)
+	      || other.process_arguments(3, const_cast<char**>(one)) <= 0
+	      || v != std::vector<int>(1, 1)) {
+	       std::cerr << "ERROR: default kept by the next parse\n";
+	       return -1;
+	  }
+     }
+     if (other.parse_cache_hits() != 2) {
+	  std::cerr << "ERROR: unexpected cache statistics with defaults\n";
+	  return -1;
+     }
+     return 0;
+}
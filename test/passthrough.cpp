@@ -0,0 +1,89 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main()
+{
+     int errors(0);
+
+     // partial parsing: unknown arguments and everything after '--'
+     {
+	  bool b(false);
+	  unsigned int offset(0);
+	  ProgramOptionManager args("wrapper", "");
+	  args.add_option("b", "bool", b, "a boolean flag");
+	  args.add_option("o", "offset", offset, "an offset");
+
+	  const char* argv[] = {"wrapper", "-o", "3", "--child-opt", "x",
+				"-b", "--", "-o", "child", NULL};
+	  char** av(const_cast<char**>(argv));
+	  PassthroughArguments unknown;
+	  const int retval(args.process_known_arguments(9, av, unknown));
+
+	  errors += check(retval > 0, "partial parsing failed");
+	  errors += check(b && offset == 3, "wrong values after partial parsing");
+	  errors += check(unknown.argc() == 4, "wrong number of passthrough args");
+	  if (unknown.argc() == 4) {
+	       const char* expected[] = {"--child-opt", "x", "-o", "child"};
+	       for (int i(0); i < 4; ++i) {
+		    errors += check(std::strcmp(unknown[i], expected[i]) == 0,
+				    "wrong passthrough argument");
+	       }
+	  }
+	  // no copy: the view points into argv and is NULL-terminated
+	  errors += check(unknown.argv() == av + 5, "view not over argv");
+	  errors += check(unknown.argv()[unknown.argc()] == NULL,
+			  "view not NULL-terminated");
+	  char child[] = "child-prog";
+	  char** child_argv(unknown.argv_with_program(child));
+	  errors += check(child_argv[0] == child && child_argv[1] == unknown[0],
+			  "wrong argv for execv");
+     }
+
+     // partially recognized arguments are still errors
+     {
+	  bool b(false);
+	  std::ostringstream err;
+	  ProgramOptionManager args("wrapper", "");
+	  args.set_error_stream(err);
+	  args.add_option("b", "bool", b, "a boolean flag");
+
+	  const char* argv[] = {"wrapper", "-bX", NULL};
+	  PassthroughArguments unknown;
+	  errors += check(args.process_known_arguments(2,
+						       const_cast<char**>(argv),
+						       unknown) < 0,
+			  "partially recognized argument accepted");
+     }
+
+     // full parsing: arguments after '--' are positional
+     {
+	  bool b(false);
+	  std::vector<std::string> files;
+	  ProgramOptionManager args("prog", "");
+	  args.add_option("b", "bool", b, "a boolean flag");
+	  args.add_option("files", files, 2, "input files");
+
+	  const char* argv[] = {"prog", "-b", "--", "-b", "file", NULL};
+	  const int retval(process(args, argv));
+	  errors += check(retval > 0, "parsing with '--' failed");
+	  errors += check(files.size() == 2 && files[0] == "-b"
+			  && files[1] == "file",
+			  "wrong positional values after '--'");
+     }
+
+     return errors;
+}
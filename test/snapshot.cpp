@@ -0,0 +1,99 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options_snapshot.hpp"
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct config {
+     unsigned int first;
+     unsigned int second;
+     std::string name;
+};
+
+void bind_config(ProgramOptionManager& args, config& c)
+{
+     args.add_option("f", "first", c.first, "first value");
+     args.add_option("s", "second", c.second, "second value");
+     args.add_option("n", "name", c.name, "some name");
+}
+
+int reload(OptionSnapshot<config>& snapshot, unsigned int value)
+{
+     std::ostringstream ssout;
+     ssout << value;
+     std::string v(ssout.str());
+     std::string name("name" + v);
+
+     std::string prog("snapshot"), f("-f"), s("-s"), n("-n");
+     char* argv[] = {&prog[0], &f[0], &v[0], &s[0], &v[0], &n[0], &name[0]};
+     return snapshot.reload(7, argv);
+}
+
+int main()
+{
+     config defaults = {0, 0, "name0"};
+     OptionSnapshot<config> snapshot("snapshot", "", bind_config, defaults);
+
+     if (snapshot.read().get() != NULL) {
+	  std::cerr << "ERROR: snapshot published before first reload!\n";
+	  return -1;
+     }
+
+     const unsigned int n_reloads(500);
+     std::atomic<bool> done(false);
+     std::atomic<unsigned int> errors(0);
+     std::vector<std::thread> readers;
+
+     for (unsigned int i(0); i < 4; ++i) {
+	  readers.push_back(std::thread([&]() {
+			 unsigned int last(0);
+			 while (!done.load()) {
+			      OptionSnapshot<config>::ReadGuard guard(snapshot.read());
+			      if (guard.get() == NULL) {
+				   continue;
+			      }
+			      std::ostringstream ssout;
+			      ssout << "name" << guard->first;
+			      if (guard->first != guard->second
+				  || guard->first < last
+				  || guard->name != ssout.str()) {
+				   ++errors;
+			      }
+			      last = guard->first;
+			      std::this_thread::yield();
+			 }
+		    }));
+     }
+
+     for (unsigned int i(1); i <= n_reloads; ++i) {
+	  if (reload(snapshot, i) <= 0) {
+	       ++errors;
+	  }
+     }
+     done = true;
+     for (unsigned int i(0); i < readers.size(); ++i) {
+	  readers[i].join();
+     }
+
+     if (snapshot.generation() != n_reloads
+	 || snapshot.read()->first != n_reloads) {
+	  std::cerr << "ERROR: last snapshot was not published!\n";
+	  return -1;
+     }
+     if (errors != 0) {
+	  std::cerr << "ERROR: " << errors << " inconsistent snapshots read\n";
+	  return -1;
+     }
+     return 0;
+}
@@ -0,0 +1,84 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace module {
+     extern unsigned int jobs;
+     extern std::string cache_dir;
+     extern std::vector<int> ids;
+     extern bool verbose;
+}
+
+std::string default_dir()
+{
+     return "/default";
+}
+
+int main()
+{
+     int errors(0);
+
+     // options registered by other translation units
+     {
+	  std::string output;
+	  ProgramOptionManager args("static", "");
+	  args.add_option("o", "output", output, "output file");
+	  args.add_static_options();
+
+	  const char* argv[] = {"static", "-j", "4", "--cache-dir", "/var/cache",
+				"-i", "1", "2", "-v", "-o", "out", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(module::jobs == 4 && module::cache_dir == "/var/cache"
+			  && module::ids.size() == 2 && module::verbose
+			  && output == "out",
+			  "wrong static option values");
+	  errors += check(args.help_text().find("--cache-dir") != std::string::npos,
+			  "static option missing from help");
+     }
+
+     // static options are only added on request
+     {
+	  std::ostringstream err;
+	  ProgramOptionManager args("static", "");
+	  args.set_error_stream(err);
+	  const char* argv[] = {"static", "--jobs", "2", NULL};
+	  errors += check(process(args, argv) < 0
+			  && args.last_error().code == ParseEvent::UNKNOWN_OPTION,
+			  "static option added without request");
+     }
+
+     // options of the manager take precedence, static options can be
+     // looked up by name before parsing
+     {
+	  int jobs(0);
+	  ProgramOptionManager args("static", "");
+	  args.add_option("j", "jobs", jobs, "jobs of main");
+	  args.add_static_options();
+	  args.set_default("cache-dir",
+			   default_from<std::string>(default_dir, "/default"));
+
+	  module::jobs = 1;
+	  const char* argv[] = {"static", "-j", "8", NULL};
+	  errors += check(process(args, argv) > 0,
+			  "parsing failed");
+	  errors += check(jobs == 8 && module::jobs == 1,
+			  "static option not overridden");
+	  errors += check(module::cache_dir == "/default",
+			  "default of static option not applied");
+     }
+
+     return errors;
+}
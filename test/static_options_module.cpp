@@ -0,0 +1,27 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+// Options of a "module", registered from another translation unit than main
+
+#include "program_options.hpp"
+
+#include <string>
+#include <vector>
+
+namespace module {
+     unsigned int jobs(1);
+     std::string cache_dir("/tmp");
+     std::vector<int> ids;
+     bool verbose(false);
+
+     StaticOption jobs_option("j", "jobs", jobs, "number of parallel jobs");
+     StaticOption cache_option("", "cache-dir", cache_dir, "cache directory");
+     StaticOption ids_option("i", "ids", ids, 2, "pairs of identifiers");
+     StaticOption verbose_option("v", "verbose", verbose, "verbose output");
+}
@@ -0,0 +1,121 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+struct counter {
+     counter() : n(0), total(0) {}
+     bool operator()(const unsigned int& v)
+	  {
+	       ++n;
+	       total += v;
+	       return true;
+	  }
+     unsigned long n;
+     unsigned long total;
+};
+
+int parse_file(const char* filename, char delimiter,
+	       unsigned long n_expected, unsigned long total_expected)
+{
+     counter count;
+     bool b(false);
+     unsigned int offset(0);
+
+     ProgramOptionManager args("prog", "");
+     args.add_option("values", for_each_value<unsigned int>(std::ref(count)),
+		     "values to sum");
+     args.add_option("b", "bool", b, "a boolean flag");
+     args.add_option("o", "offset", offset, "an offset");
+
+     const char* argv[] = {"prog", "-o", "3"};
+     const int fd(::open(filename, O_RDONLY));
+     // small chunks to exercise arguments straddling chunk boundaries
+     FdArgumentSource source(fd, delimiter, 7);
+     const int retval(args.process_arguments(3, const_cast<char**>(argv), source));
+     ::close(fd);
+
+     if (retval <= 0 || !b || offset != 3
+	 || count.n != n_expected || count.total != total_expected) {
+	  std::cerr << "ERROR: wrong values after streaming " << filename
+		    << std::endl;
+	  return -1;
+     }
+     return 0;
+}
+
+//! Invalid UTF-8 in the input is reported with its offset
+int parse_invalid_utf8(const char* filename)
+{
+     std::FILE* out(std::fopen(filename, "wb"));
+     std::fprintf(out, "caf\xc3\xa9%cna\xefve%c", '\0', '\0');
+     std::fclose(out);
+
+     std::vector<std::string> words;
+     std::ostringstream err;
+     ProgramOptionManager args("prog", "");
+     args.set_error_stream(err);
+     args.add_option("words", words, anything_but_last(), "words");
+
+     const char* argv[] = {"prog"};
+     const int fd(::open(filename, O_RDONLY));
+     FdArgumentSource source(fd, '\0', 3);
+     source.set_utf8_check(true);
+     const int retval(args.process_arguments(1, const_cast<char**>(argv), source));
+     ::close(fd);
+
+     if (retval >= 0 || args.last_error().code != ParseEvent::INPUT_ERROR
+	 || err.str().find("invalid UTF-8 at byte 8") == std::string::npos) {
+	  std::cerr << "ERROR: invalid UTF-8 input accepted" << std::endl;
+	  return -1;
+     }
+     return 0;
+}
+
+int main()
+{
+     const char* filename("streaming_test.txt");
+     const unsigned long n(100000);
+
+     for (unsigned int pass(0); pass < 2; ++pass) {
+	  const char delimiter(pass == 0 ? '\0' : '\n');
+
+	  std::FILE* out(std::fopen(filename, "wb"));
+	  unsigned long total(0);
+	  for (unsigned long i(0); i < n; ++i) {
+	       std::fprintf(out, "%lu%c", i, delimiter);
+	       total += i;
+	       if (i == n / 2) {
+		    std::fprintf(out, "--bool%c", delimiter);
+	       }
+	  }
+	  // last argument without delimiter
+	  std::fprintf(out, "%lu", n);
+	  total += n;
+	  std::fclose(out);
+
+	  if (parse_file(filename, delimiter, n + 1, total) != 0) {
+	       return -1;
+	  }
+     }
+
+     if (parse_invalid_utf8(filename) != 0) {
+	  return -1;
+     }
+
+     std::remove(filename);
+     return 0;
+}
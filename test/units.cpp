@@ -0,0 +1,109 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//! Parse a single value of type T given to option -x
+template <typename T>
+bool parse(const char* arg, T& value)
+{
+     std::ostringstream err;
+     ProgramOptionManager args("units", "");
+     args.set_error_stream(err);
+     args.add_option("x", "value", value, "a value");
+     const char* argv[] = {"units", "-x", arg, NULL};
+     return process(args, argv) > 0;
+}
+
+int main()
+{
+     int errors(0);
+
+     // sizes
+     {
+	  ByteSize size;
+	  errors += check(parse("4096", size) && size.bytes == 4096,
+			  "size without unit");
+	  errors += check(parse("64GiB", size) && size.bytes == (64ULL << 30),
+			  "binary size");
+	  errors += check(parse("1.5MB", size) && size.bytes == 1500000,
+			  "decimal fractional size");
+	  errors += check(parse("1.5KiB", size) && size.bytes == 1536,
+			  "binary fractional size");
+	  errors += check(parse("18446744073709551615", size)
+			  && size.bytes == 18446744073709551615ULL,
+			  "largest size");
+	  errors += check(!parse("18446744073709551616", size),
+			  "size overflow accepted");
+	  errors += check(!parse("20000000TiB", size),
+			  "scaled size overflow accepted");
+	  errors += check(!parse("0.5B", size), "fractional byte accepted");
+	  errors += check(!parse("3EiB", size) && !parse("MiB", size)
+			  && !parse("-1", size) && !parse("1 MiB", size),
+			  "invalid size accepted");
+     }
+
+     // durations
+     {
+	  std::chrono::milliseconds ms;
+	  errors += check(parse("250ms", ms) && ms.count() == 250,
+			  "duration in milliseconds");
+	  errors += check(parse("1.5s", ms) && ms.count() == 1500,
+			  "fractional duration");
+	  errors += check(parse("2m", ms) && ms.count() == 120000,
+			  "duration in minutes");
+	  errors += check(parse("10", ms) && ms.count() == 10,
+			  "duration without unit");
+	  errors += check(!parse("1us", ms), "inexact duration accepted");
+	  errors += check(!parse("10d", ms), "invalid unit accepted");
+
+	  std::chrono::seconds s;
+	  errors += check(parse("1h", s) && s.count() == 3600,
+			  "duration in hours");
+	  errors += check(parse("0.25m", s) && s.count() == 15,
+			  "fractional minutes");
+
+	  std::chrono::duration<int, std::micro> us;
+	  errors += check(!parse("1h", us), "duration overflowing target accepted");
+
+	  std::chrono::duration<double> seconds;
+	  errors += check(parse("1.5s", seconds) && seconds.count() == 1.5,
+			  "fractional seconds as double");
+	  errors += check(parse("250ms", seconds) && seconds.count() == 0.25,
+			  "milliseconds as double seconds");
+	  std::chrono::duration<double, std::milli> milli;
+	  errors += check(parse("0.5ms", milli) && milli.count() == 0.5,
+			  "fractional milliseconds as double");
+	  errors += check(parse("3", milli) && milli.count() == 3.,
+			  "double duration without unit");
+     }
+
+     // sizes as value counts, units in help
+     {
+	  ByteSize count;
+	  std::vector<int> values;
+	  ProgramOptionManager args("units", "");
+	  args.add_option("n", count, "number of values");
+	  args.add_option("values", values, count_depends_on("n"), "some values");
+	  const char* argv[] = {"units", "3", "1", "2", "3", NULL};
+	  errors += check(process(args, argv) > 0
+			  && count.bytes == 3 && values.size() == 3,
+			  "size as value count");
+	  errors += check(args.help_text().find("units: B, kB") != std::string::npos,
+			  "size units missing from help");
+     }
+
+     return errors;
+}
@@ -0,0 +1,87 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+//! Error message of the UTF-8 validator for a value
+std::string utf8_error(const std::string& value)
+{
+     std::string name(value);
+     std::ostringstream err;
+     ProgramOptionManager args("utf8", "");
+     args.set_error_stream(err);
+     args.add_option("n", "name", name, "name");
+     args.add_validator("name", valid_utf8());
+
+     const char* argv[] = {"utf8", "-n", value.c_str(), NULL};
+     if (process(args, argv) > 0) {
+	  return std::string();
+     }
+     return err.str();
+}
+
+bool rejected_at(const std::string& value, std::size_t offset)
+{
+     return utf8_error(value).find("name: invalid UTF-8 at byte "
+				   + std::to_string(offset))
+	  != std::string::npos;
+}
+
+int main()
+{
+     int errors(0);
+
+     // well-formed strings of all sequence lengths
+     const std::string ascii(1000, 'a');
+     errors += check(utf8_error("plain ascii").empty()
+		     && utf8_error("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80").empty()
+		     && utf8_error(ascii + "\xd0\x96" + ascii).empty()
+		     && utf8_error("\xef\xbf\xbf\xf4\x8f\xbf\xbf").empty(),
+		     "valid UTF-8 rejected");
+
+     // ill-formed sequences are reported at their first byte
+     errors += check(rejected_at("a\x80", 1), "stray continuation accepted");
+     errors += check(rejected_at("ab\xc0\x80", 2), "overlong encoding accepted");
+     errors += check(rejected_at("\xe0\x80\xaf", 0), "overlong encoding accepted");
+     errors += check(rejected_at("x\xed\xa0\x80", 1), "surrogate accepted");
+     errors += check(rejected_at("\xf4\x90\x80\x80", 0),
+		     "code point above U+10FFFF accepted");
+     errors += check(rejected_at("abc\xe2\x82", 3), "truncated sequence accepted");
+     errors += check(rejected_at("\xff", 0), "invalid byte accepted");
+
+     // offsets past the vectorized ASCII runs
+     for (std::size_t n(0); n < 70; ++n) {
+	  errors += check(rejected_at(std::string(n, 'x') + "\xc3(" + ascii, n),
+			  "wrong offset after ASCII run");
+     }
+     errors += check(rejected_at(ascii + "\xc3\xa9" + ascii + "\xfe", 2002),
+		     "wrong offset after mixed text");
+
+     // elements of vectors are validated too
+     {
+	  std::vector<std::string> names;
+	  std::ostringstream err;
+	  ProgramOptionManager args("utf8", "");
+	  args.set_error_stream(err);
+	  args.add_option("names", names, 2, "names");
+	  args.add_validator("names", valid_utf8());
+	  const char* argv[] = {"utf8", "ok", "n\xc3", NULL};
+	  errors += check(process(args, argv) < 0
+			  && err.str().find("names[1]: invalid UTF-8 at byte 1")
+			  != std::string::npos,
+			  "invalid vector element accepted");
+     }
+
+     return errors;
+}
@@ -0,0 +1,122 @@
+/* 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. 
+ *
+ * Authors:
+ * 2017 Damien Nguyen <damien.nguyen@alumni.epfl.ch>
+ */
+
+#include "program_options.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! Slow check (eg. stat() on a network filesystem)
+std::string slow_check(const std::string& value)
+{
+     std::this_thread::sleep_for(std::chrono::milliseconds(100));
+     return value == "bad" ? "bad value" : std::string();
+}
+
+int main(int, char** argv)
+{
+     int errors(0);
+
+     // range and path checks, errors reported in element order
+     {
+	  unsigned int level(0);
+	  std::vector<std::string> files;
+	  std::ostringstream err;
+	  ProgramOptionManager args("validators", "");
+	  args.set_error_stream(err);
+	  args.add_option("files", files, 3, "input files");
+	  args.add_option("l", "level", level, "a level");
+	  args.add_validator("files", existing_path());
+	  args.add_validator("level", in_range(1U, 9U));
+
+	  const char* ok[] = {"validators", argv[0], argv[0], argv[0],
+			      "-l", "3", NULL};
+	  errors += check(process(args, ok) > 0,
+			  "valid values rejected");
+	  args.reset();
+	  files.clear();
+
+	  const char* bad[] = {"validators", "/nonexistent/a", argv[0],
+			       "/nonexistent/b", "-l", "12", NULL};
+	  errors += check(process(args, bad) < 0,
+			  "invalid values accepted");
+	  errors += check(args.last_error().code == ParseEvent::VALIDATION_FAILED,
+			  "wrong error code");
+	  errors += check(args.option(args.last_error().option) != NULL
+			  && args.option(args.last_error().option)->help_name()
+			  == "files",
+			  "wrong option for the first error");
+	  const std::string msg(err.str());
+	  const std::size_t a(msg.find("files[0]"));
+	  const std::size_t b(msg.find("files[2]"));
+	  const std::size_t l(msg.find("--level: not in [1, 9]"));
+	  errors += check(a != std::string::npos && b != std::string::npos
+			  && l != std::string::npos && a < b && b < l,
+			  "errors missing or not in order");
+	  errors += check(msg.find("files[1]") == std::string::npos,
+			  "valid element reported");
+     }
+
+     // validators run concurrently
+     {
+	  std::vector<std::string> values;
+	  std::ostringstream err;
+	  ProgramOptionManager args("validators", "");
+	  args.set_error_stream(err);
+	  args.set_validation_threads(8);
+	  args.add_option("values", values, 9, "values");
+	  args.add_validator("values", check_with<std::string>(slow_check));
+
+	  const char* argv2[] = {"validators", "a", "b", "c", "bad",
+				 "e", "f", "g", "h", "i", NULL};
+	  const std::chrono::steady_clock::time_point start(
+	       std::chrono::steady_clock::now());
+	  const int retval(process(args, argv2));
+	  const long elapsed(static_cast<long>(
+				  std::chrono::duration_cast<std::chrono::milliseconds>(
+				       std::chrono::steady_clock::now() - start).count()));
+	  errors += check(retval < 0, "bad value accepted");
+	  errors += check(err.str().find("values[3]: bad value")
+			  != std::string::npos,
+			  "wrong error message");
+	  errors += check(elapsed < 400, "validators did not run concurrently");
+
+	  // the threads are kept for the next parse
+	  args.reset();
+	  values.clear();
+	  err.str("");
+	  const std::chrono::steady_clock::time_point again(
+	       std::chrono::steady_clock::now());
+	  errors += check(process(args, argv2) < 0
+			  && err.str().find("values[3]: bad value")
+			  != std::string::npos,
+			  "bad value accepted by the second parse");
+	  errors += check(std::chrono::steady_clock::now() - again
+			  < std::chrono::milliseconds(400),
+			  "validators did not run concurrently again");
+     }
+
+     // mismatching validator types are rejected
+     {
+	  unsigned int level(0);
+	  std::ostringstream err;
+	  ProgramOptionManager args("validators", "");
+	  args.set_error_stream(err);
+	  args.add_option("l", "level", level, "a level");
+	  args.add_validator("level", in_range(1, 9));
+	  errors += check(err.str().find("does not match") != std::string::npos,
+			  "mismatching validator accepted");
+     }
+
+     return errors;
+}